@@ -1,7 +1,10 @@
 #ifndef AZAH_GAMES_GAME_H_
 #define AZAH_GAMES_GAME_H_
 
+#include <stdint.h>
+
 #include <array>
+#include <concepts>
 #include <span>
 #include <string_view>
 #include <type_traits>
@@ -115,6 +118,15 @@ class Game {
   //
   // Undefined if the game is over.
   // virtual void MakeMove(int move_i, absl::BitGenRef bitgen) = 0;
+
+  // Game subclasses may also implement:
+  //
+  // A hash of the game state, letting searches share the work done on a state
+  // reached through different sequences of moves. Equal states must have equal
+  // hashes, so anything that changes how the game can play out from here (say,
+  // a move counter that ends the game) must be hashed too. See zobrist.h.
+  //
+  // uint64_t Hash() const;
 };
 
 namespace internal {
@@ -138,6 +150,11 @@ concept NonDeterministicGameType =
 template <typename T>
 concept AnyGameType = DeterministicGameType<T> || NonDeterministicGameType<T>;
 
+template <typename T>
+concept HashableGameType =
+    AnyGameType<T> && requires(const T& game) {
+        { game.Hash() } -> std::same_as<uint64_t>; };
+
 }  // namespace games
 }  // namespace azah
 
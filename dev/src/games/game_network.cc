@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "../nn/data_types.h"
@@ -17,7 +18,8 @@ GameNetwork::GameNetwork(
     std::vector<uint32_t>&& policy_loss_target_indices,
     uint32_t outcome_loss_target_index,
     std::vector<uint32_t>&& policy_output_indices,
-    uint32_t outcome_output_index) :
+    uint32_t outcome_output_index,
+    int batch_n) :
         input_constant_indices_(std::move(input_constant_indices)),
         policy_target_constant_indices_(
             std::move(policy_target_constant_indices)),
@@ -25,7 +27,9 @@ GameNetwork::GameNetwork(
         policy_loss_target_indices_(std::move(policy_loss_target_indices)),
         outcome_loss_target_index_(outcome_loss_target_index),
         policy_output_indices_(std::move(policy_output_indices)),
-        outcome_output_index_(outcome_output_index) {}
+        outcome_output_index_(outcome_output_index),
+        batch_n_(batch_n),
+        batched_(nullptr) {}
 
 const std::vector<uint32_t>& GameNetwork::input_constant_indices() const {
   return input_constant_indices_;
@@ -56,6 +60,23 @@ uint32_t GameNetwork::outcome_output_index() const {
   return outcome_output_index_;
 }
 
+int GameNetwork::batch_n() const {
+  return batch_n_;
+}
+
+GameNetwork* GameNetwork::Batched() {
+  if (batched_ == nullptr) {
+    batched_ = NewBatched();
+    if (batched_ == nullptr) return nullptr;
+  }
+  if (batched_->version() != version()) batched_->CopyVariables(*this);
+  return batched_.get();
+}
+
+std::unique_ptr<GameNetwork> GameNetwork::NewBatched() const {
+  return nullptr;
+}
+
 void GameNetwork::Serialize(std::ostream& out) const {
   std::vector<nn::ConstDynamicMatrixRef> vars;
   GetVariables({}, vars);
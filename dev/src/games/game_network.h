@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <memory>
 #include <type_traits>
 #include <vector>
 
@@ -25,7 +26,8 @@ class GameNetwork : public nn::Network, io::Serializable {
       std::vector<uint32_t>&& policy_loss_target_indices,
       uint32_t outcome_loss_target_index,
       std::vector<uint32_t>&& policy_output_indices,
-      uint32_t outcome_output_index);
+      uint32_t outcome_output_index,
+      int batch_n = 1);
 
   const std::vector<uint32_t>& input_constant_indices() const;
   
@@ -38,9 +40,24 @@ class GameNetwork : public nn::Network, io::Serializable {
   const std::vector<uint32_t>& policy_output_indices() const;
   uint32_t outcome_output_index() const;
 
+  // The number of game states evaluated at once. Every input and output holds
+  // that many blocks of columns side by side, one per state, each shaped as it
+  // is for a single state.
+  int batch_n() const;
+
+  // A network of the same kind with batch_n() > 1 and this network's weights,
+  // or nullptr if there's no such kind. It's created on first use and copies
+  // the variables again whenever they've changed since, so like this network
+  // it's only to be used by one thread at a time.
+  GameNetwork* Batched();
+
   void Serialize(std::ostream& out) const override;
   void Deserialize(std::istream& in) override;
 
+ protected:
+  // Returns a new network for Batched, or nullptr.
+  virtual std::unique_ptr<GameNetwork> NewBatched() const;
+
  private:
   const std::vector<uint32_t> input_constant_indices_;
 
@@ -52,6 +69,9 @@ class GameNetwork : public nn::Network, io::Serializable {
 
   const std::vector<uint32_t> policy_output_indices_;
   const uint32_t outcome_output_index_;
+
+  const int batch_n_;
+  std::unique_ptr<GameNetwork> batched_;
 };
 
 template <typename T>
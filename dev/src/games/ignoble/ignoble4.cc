@@ -1,6 +1,7 @@
 #include "ignoble4.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
 #include <array>
@@ -11,6 +12,7 @@
 #include "../../nn/data_types.h"
 #include "../../nn/init.h"
 #include "../game.h"
+#include "../zobrist.h"
 #include "absl/random/bit_gen_ref.h"
 #include "absl/random/random.h"
 #include "glog/logging.h"
@@ -137,13 +139,18 @@ IntType bounty_value(IntType stock_value, IntType modifier) {
 
 Ignoble4::Ignoble4() :
     jump_label_(kJumpInit),
+    s_{},
     decision_class_(Decisions::kTeamSelect),
     deck_select_tie_order_{0, 1, 2, 3},
+    hand_{},
     hand_size_{0, 0, 0, 0},
     stock_n_{{{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}},
+    locations_in_play_{},
     current_location_i_(0),
     location_deck_{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11},
     top_of_deck_i_(-1),
+    cards_in_play_{},
+    ounce_hot_seat_(0),
     winning_player_i_(-1),
     out_of_time_(false),
     out_of_time_outcome_{-1, -1, -1, -1},
@@ -155,14 +162,19 @@ Ignoble4::Ignoble4() :
 
 Ignoble4::Ignoble4(const std::vector<int>& fixed_deck_select_tie_order) :
     jump_label_(kJumpInit),
+    s_{},
     fixed_deck_select_tie_order_(fixed_deck_select_tie_order),
     decision_class_(Decisions::kTeamSelect),
     deck_select_tie_order_{0, 1, 2, 3},
+    hand_{},
     hand_size_{0, 0, 0, 0},
     stock_n_{{{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}},
+    locations_in_play_{},
     current_location_i_(0),
     location_deck_{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11},
     top_of_deck_i_(-1),
+    cards_in_play_{},
+    ounce_hot_seat_(0),
     winning_player_i_(-1),
     out_of_time_(false),
     out_of_time_outcome_{-1, -1, -1, -1},
@@ -893,6 +905,67 @@ MakeMove_RepentStock:
   }
 }
 
+uint64_t Ignoble4::Hash() const {
+  // Everything MakeMove reads is hashed, including the paused play state. The
+  // cached values at the end of the class follow from the rest.
+  ZobristHash hash;
+  hash.Add(jump_label_);
+  hash.Add(s_.i);
+  hash.Add(s_.q);
+  for (IndexT x : s_.pick_order) hash.Add(x);
+  for (IndexT x : s_.available_decks) hash.Add(x);
+  hash.Add(s_.pick);
+  for (bool x : s_.repent_check) hash.Add(x);
+  for (IndexT x : s_.player_selected_index) hash.Add(x);
+  for (IndexT x : s_.select_order) hash.Add(x);
+  hash.Add(s_.x);
+  hash.Add(s_.bethesda_hand_i);
+  hash.Add(s_.played_card_i);
+  hash.Add(s_.loc_i);
+  hash.Add(s_.stock_modifier);
+  hash.Add(s_.full);
+  for (IndexT x : s_.tossable_types) hash.Add(x);
+  hash.Add(s_.tossable_types_n);
+  hash.Add(s_.type);
+  hash.Add(s_.s);
+  hash.Add(s_.bungler_tossed);
+  hash.Add(s_.bounty_value);
+  hash.Add(s_.bounty_type);
+  hash.Add(s_.total_stock);
+  hash.Add(s_.adj_bounty_value);
+  for (IndexT x : s_.repent_order) hash.Add(x);
+
+  for (const auto* order : {&fixed_deck_select_tie_order_, 
+                            &fixed_select_order_, &fixed_repent_order_}) {
+    hash.Add(static_cast<int>(order->size()));
+    for (int x : *order) hash.Add(x);
+  }
+
+  hash.Add(static_cast<int>(decision_class_));
+  for (IndexT x : deck_select_tie_order_) hash.Add(x);
+  for (int player_x = 0; player_x < 4; ++player_x) {
+    hash.Add(hand_size_[player_x]);
+    // Cards past the end of a hand are stale.
+    for (int card_i = 0; card_i < 4; ++card_i) {
+      hash.Add((card_i < hand_size_[player_x]) ? hand_[player_x][card_i] : -1);
+    }
+    for (IndexT x : stock_n_[player_x]) hash.Add(x);
+  }
+  for (IndexT x : locations_in_play_) hash.Add(x);
+  hash.Add(current_location_i_);
+  for (IndexT x : location_deck_) hash.Add(x);
+  hash.Add(top_of_deck_i_);
+  for (const PlayedCard& card : cards_in_play_) {
+    hash.Add(card.value);
+    hash.Add(card.player_i);
+  }
+  hash.Add(ounce_hot_seat_);
+  hash.Add(winning_player_i_);
+  hash.Add(out_of_time_);
+  hash.Add(depth_);
+  return hash.hash();
+}
+
 void Ignoble4::SetLocations(const std::vector<int>& in_play,
                             const std::vector<int>& deck) {
   for (auto in_play_card : in_play) {
@@ -39,6 +39,8 @@ class Ignoble4 : public Game<4> {
 
   void MakeMove(int move_i, absl::BitGenRef bitgen);
 
+  uint64_t Hash() const;
+
   // For simulating deterministic scenarios, not used during learning.
   void SetLocations(const std::vector<int>& in_play, 
                     const std::vector<int>& deck);
@@ -1,5 +1,7 @@
 #include "ignoble4_network.h"
 
+#include <memory>
+
 #include "../../nn/init.h"
 #include "../game_network.h"
 
@@ -7,7 +9,8 @@ namespace azah {
 namespace games {
 namespace ignoble {
   
-Ignoble4Network::Ignoble4Network() :
+template <int BatchN>
+BatchedIgnoble4Network<BatchN>::BatchedIgnoble4Network() :
     GameNetwork(
         {0, 1, 2, 3, 4}, 
         {5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, 
@@ -15,12 +18,13 @@ Ignoble4Network::Ignoble4Network() :
         {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 
         11, 
         {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 
-        11),
-    input_pos_1_(nn::init::Zeros<129, 1>()),
-    input_pos_2_(nn::init::Zeros<129, 1>()),
-    input_pos_3_(nn::init::Zeros<129, 1>()),
-    input_pos_4_(nn::init::Zeros<129, 1>()),
-    input_global_(nn::init::Zeros<60, 1>()),
+        11,
+        BatchN),
+    input_pos_1_(nn::init::Zeros<129, BatchN>()),
+    input_pos_2_(nn::init::Zeros<129, BatchN>()),
+    input_pos_3_(nn::init::Zeros<129, BatchN>()),
+    input_pos_4_(nn::init::Zeros<129, BatchN>()),
+    input_global_(nn::init::Zeros<60, BatchN>()),
     input_embedding_k_(
         nn::init::GlorotUniform<kExpandFeatureDepth, 129, kFeatureDepth, 129>()),
     input_embedding_pos_1_(input_embedding_k_, input_pos_1_),
@@ -35,61 +39,61 @@ Ignoble4Network::Ignoble4Network() :
     global_to_features_(input_global_embedding_, concat_3_),
     mix_1_(global_to_features_),
     // This cast is to prevent this being interpreted as a copy.
-    mix_2_(static_cast<nn::Node<kFeatureDepth, 16>&>(mix_1_)),
+    mix_2_(static_cast<nn::Node<kFeatureDepth, 16 * BatchN>&>(mix_1_)),
     final_norm_(mix_2_),
     pool_(final_norm_),
     pool_fork_(pool_, 2),
     p_team_select_linear_k_(nn::init::GlorotUniform<4, kFeatureDepth>()),
     p_team_select_linear_(p_team_select_linear_k_, pool_fork_),
     p_team_select_(p_team_select_linear_),
-    p_team_select_target_(nn::init::Zeros<4, 1>()),
+    p_team_select_target_(nn::init::Zeros<4, BatchN>()),
     p_team_select_loss_(p_team_select_linear_, p_team_select_target_),
     p_character_select_linear_k_(nn::init::GlorotUniform<16, kFeatureDepth>()),
     p_character_select_linear_(p_character_select_linear_k_, pool_fork_),
     p_character_select_(p_character_select_linear_),
-    p_character_select_target_(nn::init::Zeros<16, 1>()),
+    p_character_select_target_(nn::init::Zeros<16, BatchN>()),
     p_character_select_loss_(p_character_select_linear_,
                              p_character_select_target_),
     p_princess_stock_linear_k_(nn::init::GlorotUniform<4, kFeatureDepth>()),
     p_princess_stock_linear_(p_princess_stock_linear_k_, pool_fork_),
     p_princess_stock_(p_princess_stock_linear_),
-    p_princess_stock_target_(nn::init::Zeros<4, 1>()),
+    p_princess_stock_target_(nn::init::Zeros<4, BatchN>()),
     p_princess_stock_loss_(p_princess_stock_linear_, p_princess_stock_target_),
     p_meat_bungler_toss_linear_k_(
         nn::init::GlorotUniform<2, kFeatureDepth>()),
     p_meat_bungler_toss_linear_(p_meat_bungler_toss_linear_k_, pool_fork_),
     p_meat_bungler_toss_(p_meat_bungler_toss_linear_),
-    p_meat_bungler_toss_target_(nn::init::Zeros<2, 1>()),
+    p_meat_bungler_toss_target_(nn::init::Zeros<2, BatchN>()),
     p_meat_bungler_toss_loss_(p_meat_bungler_toss_linear_,
                               p_meat_bungler_toss_target_),
     p_meat_bungler_stock_linear_k_(
         nn::init::GlorotUniform<2, kFeatureDepth>()),
     p_meat_bungler_stock_linear_(p_meat_bungler_stock_linear_k_, pool_fork_),
     p_meat_bungler_stock_(p_meat_bungler_stock_linear_),
-    p_meat_bungler_stock_target_(nn::init::Zeros<2, 1>()),
+    p_meat_bungler_stock_target_(nn::init::Zeros<2, BatchN>()),
     p_meat_bungler_stock_loss_(p_meat_bungler_stock_linear_,
                                p_meat_bungler_stock_target_),
     p_merry_pieman_stock_linear_k_(nn::init::GlorotUniform<4, kFeatureDepth>()),
     p_merry_pieman_stock_linear_(p_merry_pieman_stock_linear_k_, pool_fork_),
     p_merry_pieman_stock_(p_merry_pieman_stock_linear_),
-    p_merry_pieman_stock_target_(nn::init::Zeros<4, 1>()),
+    p_merry_pieman_stock_target_(nn::init::Zeros<4, BatchN>()),
     p_merry_pieman_stock_loss_(p_merry_pieman_stock_linear_, 
                                p_merry_pieman_stock_target_),
     p_benedict_increase_linear_k_(nn::init::GlorotUniform<2, kFeatureDepth>()),
     p_benedict_increase_linear_(p_benedict_increase_linear_k_, pool_fork_),
     p_benedict_increase_(p_benedict_increase_linear_),
-    p_benedict_increase_target_(nn::init::Zeros<2, 1>()),
+    p_benedict_increase_target_(nn::init::Zeros<2, BatchN>()),
     p_benedict_increase_loss_(p_benedict_increase_linear_, 
                               p_benedict_increase_target_),
     p_bethesda_swap_linear_k_(nn::init::GlorotUniform<2, kFeatureDepth>()),
     p_bethesda_swap_linear_(p_bethesda_swap_linear_k_, pool_fork_),
     p_bethesda_swap_(p_bethesda_swap_linear_),
-    p_bethesda_swap_target_(nn::init::Zeros<2, 1>()),
+    p_bethesda_swap_target_(nn::init::Zeros<2, BatchN>()),
     p_bethesda_swap_loss_(p_bethesda_swap_linear_, p_bethesda_swap_target_),
     p_ounce_steal_stock_linear_k_(nn::init::GlorotUniform<4, kFeatureDepth>()),
     p_ounce_steal_stock_linear_(p_ounce_steal_stock_linear_k_, pool_fork_),
     p_ounce_steal_stock_(p_ounce_steal_stock_linear_),
-    p_ounce_steal_stock_target_(nn::init::Zeros<4, 1>()),
+    p_ounce_steal_stock_target_(nn::init::Zeros<4, BatchN>()),
     p_ounce_steal_stock_loss_(p_ounce_steal_stock_linear_, 
                               p_ounce_steal_stock_target_),
     p_magician_stock_take_toss_linear_k_(
@@ -97,18 +101,18 @@ Ignoble4Network::Ignoble4Network() :
     p_magician_stock_take_toss_linear_(p_magician_stock_take_toss_linear_k_, 
                                        pool_fork_),
     p_magician_stock_take_toss_(p_magician_stock_take_toss_linear_),
-    p_magician_stock_take_toss_target_(nn::init::Zeros<8, 1>()),
+    p_magician_stock_take_toss_target_(nn::init::Zeros<8, BatchN>()),
     p_magician_stock_take_toss_loss_(p_magician_stock_take_toss_linear_,
                                      p_magician_stock_take_toss_target_),
     p_repent_stock_linear_k_(nn::init::GlorotUniform<5, kFeatureDepth>()),
     p_repent_stock_linear_(p_repent_stock_linear_k_, pool_fork_),
     p_repent_stock_(p_repent_stock_linear_),
-    p_repent_stock_target_(nn::init::Zeros<5, 1>()),
+    p_repent_stock_target_(nn::init::Zeros<5, BatchN>()),
     p_repent_stock_loss_(p_repent_stock_linear_, p_repent_stock_target_),
     outcome_linear_k_(nn::init::GlorotUniform<4, kFeatureDepth>()),
     outcome_linear_(outcome_linear_k_, pool_fork_),
     outcome_(outcome_linear_),
-    outcome_target_(nn::init::Zeros<4, 1>()),
+    outcome_target_(nn::init::Zeros<4, BatchN>()),
     outcome_loss_(outcome_linear_, outcome_target_) {
   AddOutput(&p_team_select_);
   AddOutput(&p_character_select_);
@@ -173,6 +177,19 @@ Ignoble4Network::Ignoble4Network() :
   AddConstant(&outcome_target_);
 }
 
+template <int BatchN>
+std::unique_ptr<GameNetwork> 
+    BatchedIgnoble4Network<BatchN>::NewBatched() const {
+  if constexpr (BatchN == 1) {
+    return std::make_unique<BatchedIgnoble4Network<kBatchN>>();
+  } else {
+    return nullptr;
+  }
+}
+
+template class BatchedIgnoble4Network<1>;
+template class BatchedIgnoble4Network<kBatchN>;
+
 }  // namespace ignoble
 }  // namespace games
 }  // namespace azah
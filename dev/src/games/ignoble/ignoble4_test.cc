@@ -0,0 +1,89 @@
+#include "ignoble4.h"
+
+#include <stdint.h>
+
+#include <random>
+#include <vector>
+
+#include "../../nn/data_types.h"
+#include "../game.h"
+#include "absl/container/flat_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace games {
+namespace ignoble {
+namespace {
+
+// Everything the player to move sees of game: its inputs, whose turn it is
+// and the moves they have.
+std::vector<float> Observation(const Ignoble4& game) {
+  std::vector<float> observation;
+  for (const nn::DynamicMatrix& input : game.StateToMatrix()) {
+    observation.insert(observation.end(), input.data(),
+                       input.data() + input.size());
+  }
+  observation.push_back(game.CurrentPlayerI());
+  observation.push_back(game.PolicyClassI());
+  observation.push_back(game.CurrentMovesN());
+  return observation;
+}
+
+TEST(Ignoble4Test, ReplayedGamesHashEqual) {
+  std::mt19937 moves_bitgen(3);
+  for (int game_i = 0; game_i < 20; ++game_i) {
+    Ignoble4 game_a;
+    Ignoble4 game_b(game_a);
+    std::mt19937 bitgen_a(game_i);
+    std::mt19937 bitgen_b(game_i);
+    while (game_a.State() == GameState::kOngoing) {
+      ASSERT_EQ(game_a.Hash(), game_b.Hash());
+      int move_i = std::uniform_int_distribution<int>(
+          0, game_a.CurrentMovesN() - 1)(moves_bitgen);
+      game_a.MakeMove(move_i, bitgen_a);
+      game_b.MakeMove(move_i, bitgen_b);
+    }
+    EXPECT_EQ(game_a.Hash(), game_b.Hash());
+  }
+}
+
+TEST(Ignoble4Test, EqualHashesLookEqual) {
+  // The states that pairs of moves from the states of a few games lead to,
+  // with the same chance events. Hidden cards make states that look the same
+  // differ, but states that hash the same must look the same.
+  std::mt19937 bitgen(5);
+  absl::flat_hash_map<uint64_t, std::vector<float>> observations;
+  int transpositions_n = 0;
+  for (int game_i = 0; game_i < 5; ++game_i) {
+    Ignoble4 game;
+    while (game.State() == GameState::kOngoing) {
+      absl::flat_hash_map<uint64_t, int> pair_hashes;
+      for (int move_i = 0; move_i < game.CurrentMovesN(); ++move_i) {
+        Ignoble4 moved_game(game);
+        std::mt19937 pair_bitgen(game_i);
+        moved_game.MakeMove(move_i, pair_bitgen);
+        if (moved_game.State() != GameState::kOngoing) continue;
+        for (int move_j = 0; move_j < moved_game.CurrentMovesN(); ++move_j) {
+          Ignoble4 next_game(moved_game);
+          std::mt19937 next_bitgen(pair_bitgen);
+          next_game.MakeMove(move_j, next_bitgen);
+          if (next_game.State() != GameState::kOngoing) continue;
+          if (!pair_hashes.try_emplace(next_game.Hash(), 0).second) {
+            ++transpositions_n;
+          }
+          auto [iter, is_new] = observations.try_emplace(
+              next_game.Hash(), Observation(next_game));
+          ASSERT_EQ(iter->second, Observation(next_game));
+        }
+      }
+      game.MakeMove(std::uniform_int_distribution<int>(
+          0, game.CurrentMovesN() - 1)(bitgen), bitgen);
+    }
+  }
+  EXPECT_GT(transpositions_n, 0);
+}
+
+}  // namespace
+}  // namespace ignoble
+}  // namespace games
+}  // namespace azah
@@ -1,5 +1,7 @@
 #include "mancala.h"
 
+#include <stdint.h>
+
 #include <array>
 #include <string_view>
 #include <vector>
@@ -7,6 +9,7 @@
 #include "../../nn/data_types.h"
 #include "../../nn/init.h"
 #include "../game.h"
+#include "../zobrist.h"
 
 namespace azah {
 namespace games {
@@ -156,6 +159,20 @@ void Mancala::MakeMove(int move_i) {
   }
 }
 
+uint64_t Mancala::Hash() const {
+  // The filled pockets follow from the board and turn while the game is on,
+  // but are left as they were once it's over, and still give the moves.
+  ZobristHash hash;
+  for (int stones_n : board_) hash.Add(stones_n);
+  hash.Add(player_a_turn_);
+  hash.Add(over_);
+  hash.Add(filled_pockets_n_);
+  for (std::size_t i = 0; i < filled_pockets_n_; ++i) {
+    hash.Add(filled_pockets_[i]);
+  }
+  return hash.hash();
+}
+
 }  // namespace mancala
 }  // namespace games
 }  // namespace azah
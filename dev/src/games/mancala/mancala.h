@@ -2,6 +2,7 @@
 #define AZAH_GAMES_MANCALA_MANCALA_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <array>
 #include <string_view>
@@ -33,6 +34,8 @@ class Mancala : public Game<2> {
 
   void MakeMove(int move_i);
 
+  uint64_t Hash() const;
+
  private:
   static constexpr std::string_view kName_ = "Mancala";
 
@@ -1,5 +1,7 @@
 #include "mancala_network.h"
 
+#include <memory>
+
 #include "../../nn/init.h"
 #include "../game_network.h"
 
@@ -7,9 +9,10 @@ namespace azah {
 namespace games {
 namespace mancala {
 
-MancalaNetwork::MancalaNetwork() :
-    GameNetwork({0}, {1}, 2, {0}, 1, {0}, 1),
-    input_(nn::init::Zeros<48, 14>()),
+template <int BatchN>
+BatchedMancalaNetwork<BatchN>::BatchedMancalaNetwork() :
+    GameNetwork({0}, {1}, 2, {0}, 1, {0}, 1, BatchN),
+    input_(nn::init::Zeros<48, 14 * BatchN>()),
     input_embedding_k_(nn::init::GlorotUniform<kFeatureDepth, 48>()),
     input_embedding_(input_embedding_k_, input_),
     mix_(input_embedding_),
@@ -19,12 +22,12 @@ MancalaNetwork::MancalaNetwork() :
     policy_linear_k_(nn::init::GlorotUniform<6, kFeatureDepth>()),
     policy_linear_(policy_linear_k_, pool_fork_),
     policy_(policy_linear_),
-    policy_target_(nn::init::Zeros<6, 1>()),
+    policy_target_(nn::init::Zeros<6, BatchN>()),
     policy_loss_(policy_linear_, policy_target_),
     outcome_linear_k_(nn::init::GlorotUniform<2, kFeatureDepth>()),
     outcome_linear_(outcome_linear_k_, pool_fork_),
     outcome_(outcome_linear_),
-    outcome_target_(nn::init::Zeros<2, 1>()),
+    outcome_target_(nn::init::Zeros<2, BatchN>()),
     outcome_loss_(outcome_linear_, outcome_target_) {
   AddOutput(&policy_);
   AddOutput(&outcome_);
@@ -43,6 +46,18 @@ MancalaNetwork::MancalaNetwork() :
   AddConstant(&outcome_target_);
 }
 
+template <int BatchN>
+std::unique_ptr<GameNetwork> BatchedMancalaNetwork<BatchN>::NewBatched() const {
+  if constexpr (BatchN == 1) {
+    return std::make_unique<BatchedMancalaNetwork<kBatchN>>();
+  } else {
+    return nullptr;
+  }
+}
+
+template class BatchedMancalaNetwork<1>;
+template class BatchedMancalaNetwork<kBatchN>;
+
 }  // namespace mancala
 }  // namespace games
 }  // namespace azah
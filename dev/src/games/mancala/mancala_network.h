@@ -1,6 +1,8 @@
 #ifndef AZAH_GAMES_MANCALA_MANCALA_NETWORK_H_
 #define AZAH_GAMES_MANCALA_MANCALA_NETWORK_H_
 
+#include <memory>
+
 #include "../../nn/constant.h"
 #include "../../nn/op/fork.h"
 #include "../../nn/op/layer_norm.h"
@@ -17,12 +19,21 @@ namespace azah {
 namespace games {
 namespace mancala {
 
-class MancalaNetwork : public GameNetwork {
+// The number of boards the network returned by GameNetwork::Batched evaluates
+// at once.
+inline constexpr int kBatchN = 8;
+
+// Evaluates BatchN boards at once; see GameNetwork::batch_n.
+template <int BatchN>
+class BatchedMancalaNetwork : public GameNetwork {
  public:
-  MancalaNetwork(const MancalaNetwork&) = delete;
-  MancalaNetwork& operator=(const MancalaNetwork&) = delete;
+  BatchedMancalaNetwork(const BatchedMancalaNetwork&) = delete;
+  BatchedMancalaNetwork& operator=(const BatchedMancalaNetwork&) = delete;
 
-  MancalaNetwork();
+  BatchedMancalaNetwork();
+
+ protected:
+  std::unique_ptr<GameNetwork> NewBatched() const override;
 
  private:
   static constexpr int kFeatureDepth = 64;
@@ -32,45 +43,48 @@ class MancalaNetwork : public GameNetwork {
 
   // Board must be rotated such that the current player's pockets are along the
   // first 7 cols.
-  nn::Constant<48, 14> input_;
+  nn::Constant<48, 14 * BatchN> input_;
 
   // Start by applying the same linear transformation to each 48-D one-hot
   // input.
   nn::Variable<kFeatureDepth, 48> input_embedding_k_;
-  nn::op::Matmul<kFeatureDepth, 48, 48, 14> input_embedding_;
+  nn::op::Matmul<kFeatureDepth, 48, 48, 14 * BatchN> input_embedding_;
 
   // MLP-Mixer: https://arxiv.org/pdf/2105.01601.pdf
-  nn::op::Mixer<kFeatureDepth, 14, kMixerTokenDepth, kMixerFeatureDepth> mix_;
+  nn::op::Mixer<kFeatureDepth, 14, kMixerTokenDepth, kMixerFeatureDepth, BatchN>
+      mix_;
 
   // One final norm and average pool.
-  nn::op::LayerNorm<kFeatureDepth, 14> final_norm_;
-  nn::op::RowMean<kFeatureDepth, 14> pool_;
+  nn::op::LayerNorm<kFeatureDepth, 14 * BatchN> final_norm_;
+  nn::op::RowMean<kFeatureDepth, 14, BatchN> pool_;
 
   // Fork final layer to outputs
 
   // This little optimization only works because we'll always backprop two
   // losses from the model at a time: the outcome and policy.
-  nn::op::Fork<kFeatureDepth, 1> pool_fork_;
+  nn::op::Fork<kFeatureDepth, BatchN> pool_fork_;
 
   // Policy head
 
   nn::Variable<6, kFeatureDepth> policy_linear_k_;
-  nn::op::Matmul<6, kFeatureDepth, kFeatureDepth, 1> policy_linear_;
-  nn::op::Softmax<6, 1> policy_;
+  nn::op::Matmul<6, kFeatureDepth, kFeatureDepth, BatchN> policy_linear_;
+  nn::op::Softmax<6, BatchN> policy_;
 
-  nn::Constant<6, 1> policy_target_;
-  nn::op::SoftmaxCrossEnt<6, 1> policy_loss_;
+  nn::Constant<6, BatchN> policy_target_;
+  nn::op::SoftmaxCrossEnt<6, BatchN> policy_loss_;
 
   // Outcome head
 
   nn::Variable<2, kFeatureDepth> outcome_linear_k_;
-  nn::op::Matmul<2, kFeatureDepth, kFeatureDepth, 1> outcome_linear_;
-  nn::op::Softmax<2, 1> outcome_;
+  nn::op::Matmul<2, kFeatureDepth, kFeatureDepth, BatchN> outcome_linear_;
+  nn::op::Softmax<2, BatchN> outcome_;
 
-  nn::Constant<2, 1> outcome_target_;
-  nn::op::SoftmaxCrossEnt<2, 1> outcome_loss_;
+  nn::Constant<2, BatchN> outcome_target_;
+  nn::op::SoftmaxCrossEnt<2, BatchN> outcome_loss_;
 };
 
+using MancalaNetwork = BatchedMancalaNetwork<1>;
+
 }  // namespace mancala
 }  // namespace games
 }  // namespace azah
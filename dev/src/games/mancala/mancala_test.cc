@@ -0,0 +1,85 @@
+#include "mancala.h"
+
+#include <stdint.h>
+
+#include <random>
+#include <vector>
+
+#include "../../nn/data_types.h"
+#include "absl/container/flat_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace games {
+namespace mancala {
+namespace {
+
+// Everything a player sees of game: its input, whether it's over, whose turn
+// it is and the moves they have.
+std::vector<float> Observation(const Mancala& game) {
+  std::vector<float> observation;
+  for (const nn::DynamicMatrix& input : game.StateToMatrix()) {
+    observation.insert(observation.end(), input.data(),
+                       input.data() + input.size());
+  }
+  observation.push_back(static_cast<float>(game.State()));
+  observation.push_back(game.CurrentPlayerI());
+  nn::DynamicMatrix mask = game.PolicyMask();
+  observation.insert(observation.end(), mask.data(),
+                     mask.data() + mask.size());
+  return observation;
+}
+
+// Adds the hash of every state reachable from game in depth moves to hashes,
+// keyed by the state's observation, and counts the paths to them.
+void AddHashes(const Mancala& game, int depth,
+               absl::flat_hash_map<std::vector<float>, uint64_t>& hashes,
+               int& paths_n) {
+  ++paths_n;
+  auto [iter, is_new] = hashes.try_emplace(Observation(game), game.Hash());
+  ASSERT_EQ(iter->second, game.Hash());
+  if (!is_new || (depth == 0) || (game.State() != GameState::kOngoing)) {
+    return;
+  }
+  for (int move_i = 0; move_i < game.CurrentMovesN(); ++move_i) {
+    Mancala next_game(game);
+    next_game.MakeMove(move_i);
+    AddHashes(next_game, depth - 1, hashes, paths_n);
+  }
+}
+
+TEST(MancalaTest, StatesHashApart) {
+  absl::flat_hash_map<std::vector<float>, uint64_t> hashes;
+  int paths_n = 0;
+  AddHashes(Mancala(), 6, hashes, paths_n);
+  // Some states are reached by more than one order of moves.
+  EXPECT_GT(static_cast<std::size_t>(paths_n), hashes.size());
+
+  absl::flat_hash_map<uint64_t, int> states_n;
+  for (const auto& [observation, hash] : hashes) ++states_n[hash];
+  EXPECT_EQ(states_n.size(), hashes.size());
+}
+
+TEST(MancalaTest, FinishedGamesHashApart) {
+  // Finished games keep the moves of the turn that ended them.
+  absl::flat_hash_map<std::vector<float>, uint64_t> hashes;
+  std::mt19937 bitgen(7);
+  for (int game_i = 0; game_i < 20000; ++game_i) {
+    Mancala game;
+    while (game.State() == GameState::kOngoing) {
+      game.MakeMove(std::uniform_int_distribution<int>(
+          0, game.CurrentMovesN() - 1)(bitgen));
+    }
+    auto [iter, is_new] = hashes.try_emplace(Observation(game), game.Hash());
+    ASSERT_EQ(iter->second, game.Hash());
+  }
+
+  absl::flat_hash_map<uint64_t, int> states_n;
+  for (const auto& [observation, hash] : hashes) ++states_n[hash];
+  EXPECT_EQ(states_n.size(), hashes.size());
+}
+
+}  // namespace
+}  // namespace mancala
+}  // namespace games
+}  // namespace azah
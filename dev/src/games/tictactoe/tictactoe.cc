@@ -1,5 +1,7 @@
 #include "tictactoe.h"
 
+#include <stdint.h>
+
 #include <array>
 #include <string_view>
 #include <vector>
@@ -7,6 +9,7 @@
 #include "../../nn/data_types.h"
 #include "../../nn/init.h"
 #include "../game.h"
+#include "../zobrist.h"
 #include "glog/logging.h"
 
 namespace azah {
@@ -182,6 +185,13 @@ void Tictactoe::MakeMove(int move_i) {
   LOG(FATAL) << "The given move did not exist!";
 }
 
+uint64_t Tictactoe::Hash() const {
+  ZobristHash hash;
+  for (Mark mark : board_) hash.Add(static_cast<int>(mark));
+  hash.Add(x_move_);
+  return hash.hash();
+}
+
 }  // namespace tictactoe
 }  // namespace games
 }  // namespace azah
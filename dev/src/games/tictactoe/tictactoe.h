@@ -1,6 +1,8 @@
 #ifndef AZAH_GAMES_TICTACTOE_TICTACTOE_H_
 #define AZAH_GAMES_TICTACTOE_TICTACTOE_H_
 
+#include <stdint.h>
+
 #include <array>
 #include <string_view>
 #include <vector>
@@ -31,6 +33,8 @@ class Tictactoe : public Game<2> {
 
   void MakeMove(int move_i);
 
+  uint64_t Hash() const;
+
  private:
   static constexpr std::string_view kName_ = "TicTacToe";
 
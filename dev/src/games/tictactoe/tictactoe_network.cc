@@ -1,5 +1,7 @@
 #include "tictactoe_network.h"
 
+#include <memory>
+
 #include "../../nn/init.h"
 #include "../game_network.h"
 
@@ -7,9 +9,10 @@ namespace azah {
 namespace games {
 namespace tictactoe {
 
-TictactoeNetwork::TictactoeNetwork() :
-    GameNetwork({0}, {1}, 2, {0}, 1, {0}, 1),
-    input_(nn::init::Zeros<9, 1>()),
+template <int BatchN>
+BatchedTictactoeNetwork<BatchN>::BatchedTictactoeNetwork() :
+    GameNetwork({0}, {1}, 2, {0}, 1, {0}, 1, BatchN),
+    input_(nn::init::Zeros<9, BatchN>()),
     dense1_k_(nn::init::GlorotUniform<kLayer1Depth, 9>()),
     dense1_(dense1_k_, input_),
     norm1_(dense1_),
@@ -22,12 +25,12 @@ TictactoeNetwork::TictactoeNetwork() :
     policy_linear_k_(nn::init::GlorotUniform<9, kLayer2Depth>()),
     policy_linear_(policy_linear_k_, swish2_fork_),
     policy_(policy_linear_),
-    policy_target_(nn::init::Zeros<9, 1>()),
+    policy_target_(nn::init::Zeros<9, BatchN>()),
     policy_loss_(policy_linear_, policy_target_),
     outcome_linear_k_(nn::init::GlorotUniform<2, kLayer2Depth>()),
     outcome_linear_(outcome_linear_k_, swish2_fork_),
     outcome_(outcome_linear_),
-    outcome_target_(nn::init::Zeros<2, 1>()),
+    outcome_target_(nn::init::Zeros<2, BatchN>()),
     outcome_loss_(outcome_linear_, outcome_target_) {
   AddOutput(&policy_);
   AddOutput(&outcome_);
@@ -47,6 +50,19 @@ TictactoeNetwork::TictactoeNetwork() :
   AddConstant(&outcome_target_);
 }
 
+template <int BatchN>
+std::unique_ptr<GameNetwork> 
+    BatchedTictactoeNetwork<BatchN>::NewBatched() const {
+  if constexpr (BatchN == 1) {
+    return std::make_unique<BatchedTictactoeNetwork<kBatchN>>();
+  } else {
+    return nullptr;
+  }
+}
+
+template class BatchedTictactoeNetwork<1>;
+template class BatchedTictactoeNetwork<kBatchN>;
+
 }  // namespace tictactoe
 }  // namespace games
 }  // namespace azah
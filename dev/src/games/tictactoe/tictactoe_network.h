@@ -1,6 +1,8 @@
 #ifndef AZAH_GAMES_TICTACTOE_TICTACTOE_NETWORK_H_
 #define AZAH_GAMES_TICTACTOE_TICTACTOE_NETWORK_H_
 
+#include <memory>
+
 #include "../../nn/constant.h"
 #include "../../nn/init.h"
 #include "../../nn/network.h"
@@ -17,61 +19,72 @@ namespace azah {
 namespace games {
 namespace tictactoe {
 
-class TictactoeNetwork : public GameNetwork {
+// The number of boards the network returned by GameNetwork::Batched evaluates
+// at once.
+inline constexpr int kBatchN = 16;
+
+// Evaluates BatchN boards at once; see GameNetwork::batch_n.
+template <int BatchN>
+class BatchedTictactoeNetwork : public GameNetwork {
  public:
-  TictactoeNetwork(const TictactoeNetwork&) = delete;
-  TictactoeNetwork& operator=(const TictactoeNetwork&) = delete;
+  BatchedTictactoeNetwork(const BatchedTictactoeNetwork&) = delete;
+  BatchedTictactoeNetwork& operator=(const BatchedTictactoeNetwork&) = delete;
 
-  TictactoeNetwork();
+  BatchedTictactoeNetwork();
+
+ protected:
+  std::unique_ptr<GameNetwork> NewBatched() const override;
 
  private:
   static constexpr int kLayer1Depth = 32;
   static constexpr int kLayer2Depth = 32;
 
   // HW flattened board. 1 = P1, 0 = N/A, -1 = P2.
-  nn::Constant<9, 1> input_;
+  nn::Constant<9, BatchN> input_;
 
   // Layer 1
 
   nn::Variable<kLayer1Depth, 9> dense1_k_;
-  nn::op::Matmul<kLayer1Depth, 9, 9, 1> dense1_;
+  nn::op::Matmul<kLayer1Depth, 9, 9, BatchN> dense1_;
 
-  nn::op::LayerNorm<kLayer1Depth, 1> norm1_;
-  nn::op::Swish<kLayer1Depth, 1> swish1_;
+  nn::op::LayerNorm<kLayer1Depth, BatchN> norm1_;
+  nn::op::Swish<kLayer1Depth, BatchN> swish1_;
 
   // Layer 2
 
   nn::Variable<kLayer2Depth, kLayer1Depth> dense2_k_;
-  nn::op::Matmul<kLayer2Depth, kLayer1Depth, kLayer1Depth, 1> dense2_;
+  nn::op::Matmul<kLayer2Depth, kLayer1Depth, kLayer1Depth, BatchN> dense2_;
 
-  nn::op::LayerNorm<kLayer2Depth, 1> norm2_;
-  nn::op::Swish<kLayer2Depth, 1> swish2_;
+  nn::op::LayerNorm<kLayer2Depth, BatchN> norm2_;
+  nn::op::Swish<kLayer2Depth, BatchN> swish2_;
 
   // Fork final layer to outputs
 
   // This little optimization only works because we'll always backprop two
   // losses from the model at a time: the outcome and policy.
-  nn::op::Fork<kLayer2Depth, 1> swish2_fork_;
+  nn::op::Fork<kLayer2Depth, BatchN> swish2_fork_;
 
   // Policy head
 
   nn::Variable<9, kLayer2Depth> policy_linear_k_;
-  nn::op::Matmul<9, kLayer2Depth, kLayer2Depth, 1> policy_linear_;
-  nn::op::Softmax<9, 1> policy_;
+  nn::op::Matmul<9, kLayer2Depth, kLayer2Depth, BatchN> policy_linear_;
+  nn::op::Softmax<9, BatchN> policy_;
   
-  nn::Constant<9, 1> policy_target_;
-  nn::op::SoftmaxCrossEnt<9, 1> policy_loss_;
+  nn::Constant<9, BatchN> policy_target_;
+  nn::op::SoftmaxCrossEnt<9, BatchN> policy_loss_;
 
   // Outcome head
 
   nn::Variable<2, kLayer2Depth> outcome_linear_k_;
-  nn::op::Matmul<2, kLayer2Depth, kLayer2Depth, 1> outcome_linear_;
-  nn::op::Softmax<2, 1> outcome_;
+  nn::op::Matmul<2, kLayer2Depth, kLayer2Depth, BatchN> outcome_linear_;
+  nn::op::Softmax<2, BatchN> outcome_;
 
-  nn::Constant<2, 1> outcome_target_;
-  nn::op::SoftmaxCrossEnt<2, 1> outcome_loss_;
+  nn::Constant<2, BatchN> outcome_target_;
+  nn::op::SoftmaxCrossEnt<2, BatchN> outcome_loss_;
 };
 
+using TictactoeNetwork = BatchedTictactoeNetwork<1>;
+
 }  // namespace tictactoe
 }  // namespace games
 }  // namespace azah
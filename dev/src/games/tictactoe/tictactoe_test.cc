@@ -0,0 +1,82 @@
+#include "tictactoe.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "../../nn/data_types.h"
+#include "absl/container/flat_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace games {
+namespace tictactoe {
+namespace {
+
+// Everything a player sees of game: its input, whether it's over, and if not,
+// whose turn it is and the moves they have.
+std::vector<float> Observation(const Tictactoe& game) {
+  std::vector<float> observation;
+  for (const nn::DynamicMatrix& input : game.StateToMatrix()) {
+    observation.insert(observation.end(), input.data(),
+                       input.data() + input.size());
+  }
+  observation.push_back(static_cast<float>(game.State()));
+  if (game.State() == GameState::kOngoing) {
+    observation.push_back(game.CurrentPlayerI());
+    observation.push_back(game.CurrentMovesN());
+  }
+  return observation;
+}
+
+// Adds the hash of every state reachable from game to hashes, keyed by the
+// state's observation, and counts the paths to them.
+void AddHashes(const Tictactoe& game,
+               absl::flat_hash_map<std::vector<float>, uint64_t>& hashes,
+               int& paths_n) {
+  ++paths_n;
+  auto [iter, is_new] = hashes.try_emplace(Observation(game), game.Hash());
+  ASSERT_EQ(iter->second, game.Hash());
+  if (!is_new || (game.State() != GameState::kOngoing)) return;
+  for (int move_i = 0; move_i < game.CurrentMovesN(); ++move_i) {
+    Tictactoe next_game(game);
+    next_game.MakeMove(move_i);
+    AddHashes(next_game, hashes, paths_n);
+  }
+}
+
+TEST(TictactoeTest, TransposedMovesHashEqual) {
+  // X in the top left, O in the top middle and X in the top right...
+  Tictactoe game_a;
+  game_a.MakeMove(0);
+  game_a.MakeMove(0);
+  game_a.MakeMove(0);
+  // ...with the Xs the other way around.
+  Tictactoe game_b;
+  game_b.MakeMove(2);
+  game_b.MakeMove(1);
+  game_b.MakeMove(0);
+  EXPECT_EQ(game_a.Hash(), game_b.Hash());
+
+  Tictactoe game_c;
+  game_c.MakeMove(0);
+  game_c.MakeMove(1);
+  game_c.MakeMove(0);
+  EXPECT_NE(game_a.Hash(), game_c.Hash());
+}
+
+TEST(TictactoeTest, StatesHashApart) {
+  absl::flat_hash_map<std::vector<float>, uint64_t> hashes;
+  int paths_n = 0;
+  AddHashes(Tictactoe(), hashes, paths_n);
+  EXPECT_GT(static_cast<std::size_t>(paths_n), hashes.size());
+
+  absl::flat_hash_map<uint64_t, int> states_n;
+  for (const auto& [observation, hash] : hashes) ++states_n[hash];
+  EXPECT_EQ(states_n.size(), hashes.size());
+}
+
+}  // namespace
+}  // namespace tictactoe
+}  // namespace games
+}  // namespace azah
@@ -0,0 +1,45 @@
+#ifndef AZAH_GAMES_ZOBRIST_H_
+#define AZAH_GAMES_ZOBRIST_H_
+
+#include <stdint.h>
+
+namespace azah {
+namespace games {
+
+// The random key for a game state feature holding a value. Rather than being
+// read from a table of random numbers, keys are mixed from the feature and
+// value with SplitMix64, so any number of features and values can be keyed.
+constexpr uint64_t ZobristKey(uint32_t feature_i, uint32_t value) {
+  uint64_t x = (static_cast<uint64_t>(feature_i) << 32) | value;
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+// Builds the Zobrist hash of a game state: the XOR of the keys for each of the
+// state's features and the value it holds.
+//
+// Features are numbered in the order they're added, so every state of a game
+// must add its features in the same order.
+class ZobristHash {
+ public:
+  ZobristHash() : hash_(0), feature_i_(0) {}
+
+  void Add(int value) {
+    hash_ ^= ZobristKey(feature_i_++, static_cast<uint32_t>(value));
+  }
+
+  uint64_t hash() const {
+    return hash_;
+  }
+
+ private:
+  uint64_t hash_;
+  uint32_t feature_i_;
+};
+
+}  // namespace games
+}  // namespace azah
+
+#endif  // AZAH_GAMES_ZOBRIST_H_
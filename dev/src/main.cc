@@ -27,8 +27,6 @@ constexpr int kLoadCheckpointIndex = 15000;
 
 constexpr int kCheckpointFreq = 10;
 
-constexpr int kRepeats = 10;
-
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -42,7 +40,8 @@ int main(int argc, char* argv[]) {
       .root_noise_alpha = 0.6,
       .root_noise_lerp = 0.25,
       .one_hot_breakover_moves_n = 80,
-      .exploration_scale = 0.22};
+      .exploration_scale = 0.22,
+      .root_trees_n = 10};
 
   if (kLoadCheckpointIndex > 0)  {
     std::ifstream checkpoint(
@@ -54,30 +53,9 @@ int main(int argc, char* argv[]) {
   Game game;
   absl::BitGen bitgen;
 
+  RLPlayer::EvaluateSession session = player.NewEvaluateSession(game, options);
   while (game.State() == azah::games::GameState::kOngoing) {
-    std::vector<RLPlayer::EvaluateResult> all_results;
-    for (int i = 0; i < kRepeats; ++i) {
-      all_results.push_back(player.Evaluate(game, options));
-    }
-
-    for (int i = 1; i < kRepeats; ++i) {
-      for (int q = 0; q < all_results[0].predicted_move.size(); ++q) {
-        all_results[0].predicted_move[q] += all_results[i].predicted_move[q];
-      }
-      for (int q = 0; q < 4; ++q) {
-        all_results[0].predicted_outcome[q] += 
-            all_results[i].predicted_outcome[q];
-      }
-    }
-    for (int i = 0; i < all_results[0].predicted_move.size(); ++i) {
-      all_results[0].predicted_move[i] /= kRepeats;
-    }
-    for (int i = 0; i < 4; ++i) {
-      all_results[0].predicted_outcome[i] /= kRepeats;
-    }
-
-    RLPlayer::EvaluateResult result = std::move(all_results[0]);
-
+    RLPlayer::EvaluateResult result = player.Evaluate(session);
 
     std::cout << "Outcome odds = [";
     for (int i = 0; i < Game::players_n(); ++i) {
@@ -100,6 +78,7 @@ int main(int argc, char* argv[]) {
     std::cout << "]\n";
 
     game.MakeMove(q, bitgen);
+    session.Advance(q, game);
   }
 
   /*
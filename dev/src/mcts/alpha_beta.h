@@ -0,0 +1,313 @@
+#ifndef AZAH_MCTS_ALPHA_BETA_H_
+#define AZAH_MCTS_ALPHA_BETA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "../games/game.h"
+#include "../games/game_network.h"
+#include "evaluation_cache.h"
+#include "glog/logging.h"
+#include "self_play.h"
+
+namespace azah {
+namespace mcts {
+namespace alpha_beta {
+
+struct Config {
+  // The deepest iteration of the search, in moves.
+  int max_depth;
+
+  // If not zero, the longest a search may run. The result of the deepest
+  // iteration completed in time is returned; the first iteration always
+  // completes.
+  std::chrono::microseconds time_limit = std::chrono::microseconds::zero();
+
+  // The number of transposition table entries, rounded up to a power of 2, or
+  // 0 for no table. Only used if the game is hashable.
+  std::size_t transpositions_n = 1 << 16;
+
+  // Up to about this many network evaluations are cached, so the states that
+  // every iteration of the search revisits are only evaluated once. Only used
+  // if the game is hashable.
+  std::size_t evaluation_cache_n = 1 << 16;
+
+  bool operator==(const Config&) const = default;
+};
+
+template <typename Game>
+concept TwoPlayerDeterministicGameType =
+    games::DeterministicGameType<Game> && (Game::players_n() == 2);
+
+// Iterative-deepening alpha-beta (negamax) search of two-player deterministic
+// games, with the network's outcome head as the evaluation of the states at
+// the search horizon and its policy head ordering the moves of every other
+// state. This spends a fixed number of forward passes per depth rather than a
+// number of simulations, which makes for a fast, predictable player when
+// there's little time to move.
+//
+// Scores are the outcome of the player to move, rescaled to [-1, 1]. A move
+// that hands the turn to the same player again (as in Mancala) keeps its
+// score rather than negating it. Each iteration searches the best move of the
+// last one first, and in hashable games a transposition table carries the
+// bounds and best moves found between iterations and searches. The table is
+// cleared whenever a search's network has other weights than the last one's,
+// so a searcher is best kept for as long as its network plays.
+template <TwoPlayerDeterministicGameType Game,
+          games::GameNetworkType GameNetwork>
+class Searcher {
+ public:
+  Searcher(const Searcher&) = delete;
+  Searcher& operator=(const Searcher&) = delete;
+
+  explicit Searcher(const Config& config) :
+      config_(config), version_(0), aborted_(false), may_abort_(false),
+      horizon_reached_(false), depth_n_(0), nodes_n_(0) {
+    if (config.max_depth < 1) {
+      LOG(FATAL) << "An alpha-beta search needs a depth of at least 1.";
+    }
+    if constexpr (games::HashableGameType<Game>) {
+      if (config.transpositions_n != 0) {
+        transpositions_.resize(std::bit_ceil(config.transpositions_n));
+      }
+      evaluation_cache_.set_size(config.evaluation_cache_n);
+    }
+  }
+
+  // Searches game, which must be ongoing, with network. The search policy of
+  // the result is one-hot on the best move, and its outcome is the (not
+  // rotated) outcome the best move's score stands for.
+  self_play::MoveOutcome<Game> Search(const Game& game, GameNetwork* network) {
+    if (game.State() != games::GameState::kOngoing) {
+      LOG(FATAL) << "Cannot search a terminal state.";
+    }
+    if (network->version() != version_) {
+      Clear();
+      version_ = network->version();
+    }
+    network_ = network;
+    deadline_ = (config_.time_limit == std::chrono::microseconds::zero())
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() + config_.time_limit;
+    nodes_n_ = 0;
+    aborted_ = false;
+    may_abort_ = false;
+
+    const int moves_n = game.CurrentMovesN();
+    int best_move_i = 0;
+    float best_score = 0.0f;
+    for (int depth = 1; depth <= config_.max_depth; ++depth) {
+      horizon_reached_ = false;
+      int move_i;
+      float score = AlphaBeta(game, depth, -1.0f, 1.0f, &move_i);
+      if (aborted_) break;
+      best_move_i = move_i;
+      best_score = score;
+      depth_n_ = depth;
+      may_abort_ = true;
+      // Every line ended before the horizon, so deeper searches would find
+      // the same.
+      if (!horizon_reached_) break;
+    }
+
+    auto search_policy = std::unique_ptr<float[]>(new float[moves_n]);
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      search_policy[move_i] = (move_i == best_move_i) ? 1.0f : 0.0f;
+    }
+    self_play::MoveOutcome<Game> move_outcome =
+        self_play::internal::PolicyToMoveOutcome(game, search_policy);
+    int player_i = game.CurrentPlayerI();
+    move_outcome.outcome(player_i, 0) = (best_score + 1.0f) / 2.0f;
+    move_outcome.outcome(1 - player_i, 0) = (1.0f - best_score) / 2.0f;
+    return move_outcome;
+  }
+
+  // Forgets the results of earlier searches.
+  void Clear() {
+    std::fill(transpositions_.begin(), transpositions_.end(), Transposition());
+  }
+
+  const Config& config() const {
+    return config_;
+  }
+
+  // The depth of the deepest iteration the last search completed.
+  int depth_n() const {
+    return depth_n_;
+  }
+
+  // The number of states the last search visited.
+  std::size_t nodes_n() const {
+    return nodes_n_;
+  }
+
+ private:
+  using Tree = self_play::SearchTree<Game, GameNetwork>;
+  using Evaluation = self_play::internal::Evaluation<Game>;
+
+  enum class Bound : uint8_t {
+    kExact = 0,
+    kLower = 1,
+    kUpper = 2
+  };
+
+  struct Transposition {
+    uint64_t hash = 0;
+    float score = 0.0f;
+    // The depth the score was found at, or -1 if the entry is unused.
+    int16_t depth = -1;
+    int16_t move_i = -1;
+    Bound bound = Bound::kExact;
+  };
+
+  const Config config_;
+
+  GameNetwork* network_;
+  // The version of the network the transpositions were searched with.
+  uint64_t version_;
+  std::chrono::steady_clock::time_point deadline_;
+
+  // Whether the current iteration ran out of time, and whether it's allowed
+  // to.
+  bool aborted_;
+  bool may_abort_;
+  // Whether the current iteration evaluated a state at its horizon.
+  bool horizon_reached_;
+
+  int depth_n_;
+  std::size_t nodes_n_;
+
+  // Only used if the game is hashable. Indexed by the low bits of the hash.
+  std::vector<Transposition> transpositions_;
+  mcts::internal::EvaluationCache<Evaluation> evaluation_cache_;
+
+  // The score of game, which is ongoing, for the player to move, searched to
+  // depth within the window (alpha, beta). If best_move_i isn't null, it's set
+  // to the best move.
+  float AlphaBeta(const Game& game, int depth, float alpha, float beta,
+                  int* best_move_i) {
+    if (may_abort_ && (std::chrono::steady_clock::now() >= deadline_)) {
+      aborted_ = true;
+      return 0.0f;
+    }
+    ++nodes_n_;
+    const int player_i = game.CurrentPlayerI();
+
+    int tt_move_i = -1;
+    Transposition* transposition = nullptr;
+    if constexpr (games::HashableGameType<Game>) {
+      uint64_t hash = game.Hash();
+      if (!transpositions_.empty()) {
+        transposition =
+            &(transpositions_[hash & (transpositions_.size() - 1)]);
+      }
+      if ((transposition != nullptr) && (transposition->depth >= 0)
+          && (transposition->hash == hash)) {
+        tt_move_i = transposition->move_i;
+        // The root has to find a move, so it's always searched.
+        if ((best_move_i == nullptr) && (transposition->depth >= depth)) {
+          if (transposition->bound == Bound::kLower) {
+            alpha = std::max(alpha, transposition->score);
+          } else if (transposition->bound == Bound::kUpper) {
+            beta = std::min(beta, transposition->score);
+          }
+          if ((transposition->bound == Bound::kExact) || (alpha >= beta)) {
+            // Whether the line reached the horizon isn't recorded, so assume
+            // it did.
+            horizon_reached_ = true;
+            return transposition->score;
+          }
+        }
+      }
+    }
+    const float start_alpha = alpha;
+
+    Evaluation evaluation;
+    Evaluate(game, evaluation);
+    if (depth == 0) {
+      horizon_reached_ = true;
+      return 2.0f * evaluation.outcome[player_i] - 1.0f;
+    }
+
+    // The transposition's move first, then the rest by prior.
+    const int moves_n = game.CurrentMovesN();
+    std::vector<int> moves_i(moves_n);
+    std::iota(moves_i.begin(), moves_i.end(), 0);
+    std::stable_sort(moves_i.begin(), moves_i.end(), [&](int a, int b) {
+          if ((a == tt_move_i) != (b == tt_move_i)) return a == tt_move_i;
+          return evaluation.policy[a] > evaluation.policy[b];
+        });
+
+    float best_score = -std::numeric_limits<float>::infinity();
+    int best_i = moves_i[0];
+    for (int move_i : moves_i) {
+      Game child(game);
+      child.MakeMove(move_i);
+      float score;
+      if (child.State() != games::GameState::kOngoing) {
+        score = 2.0f * child.Outcome()[player_i] - 1.0f;
+      } else if (child.CurrentPlayerI() == player_i) {
+        score = AlphaBeta(child, depth - 1, alpha, beta, nullptr);
+      } else {
+        score = -AlphaBeta(child, depth - 1, -beta, -alpha, nullptr);
+      }
+      if (aborted_) return 0.0f;
+      if (score > best_score) {
+        best_score = score;
+        best_i = move_i;
+      }
+      alpha = std::max(alpha, score);
+      if (alpha >= beta) break;
+    }
+
+    if (best_move_i != nullptr) *best_move_i = best_i;
+    if constexpr (games::HashableGameType<Game>) {
+      // Deeper results replace shallower ones, and a state's results replace
+      // any others.
+      uint64_t hash = game.Hash();
+      if ((transposition != nullptr)
+          && ((transposition->hash != hash)
+              || (transposition->depth <= depth))) {
+        transposition->hash = hash;
+        transposition->score = best_score;
+        transposition->depth = depth;
+        transposition->move_i = best_i;
+        transposition->bound = (best_score <= start_alpha)
+            ? Bound::kUpper
+            : (best_score >= beta) ? Bound::kLower : Bound::kExact;
+      }
+    }
+    return best_score;
+  }
+
+  void Evaluate(const Game& game, Evaluation& evaluation) {
+    if constexpr (games::HashableGameType<Game>) {
+      if (evaluation_cache_.enabled()
+          && evaluation_cache_.Find(game.Hash(), network_->version(),
+                                    evaluation)) {
+        return;
+      }
+    }
+    Tree::EvaluateWithNetwork(game, network_, evaluation);
+    if constexpr (games::HashableGameType<Game>) {
+      if (evaluation_cache_.enabled()) {
+        evaluation_cache_.Add(game.Hash(), network_->version(), evaluation);
+      }
+    }
+  }
+};
+
+}  // namespace alpha_beta
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_ALPHA_BETA_H_
@@ -0,0 +1,116 @@
+#include "alpha_beta.h"
+
+#include <stddef.h>
+
+#include <array>
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+
+#include "../games/game.h"
+#include "../games/tictactoe/tictactoe.h"
+#include "../games/tictactoe/tictactoe_network.h"
+#include "../nn/data_types.h"
+#include "gtest/gtest.h"
+#include "self_play.h"
+
+namespace azah {
+namespace mcts {
+namespace alpha_beta {
+namespace {
+
+using Game = games::tictactoe::Tictactoe;
+using GameNetwork = games::tictactoe::TictactoeNetwork;
+
+// Plays marks on the squares given, numbered row by row from the top left.
+Game Play(std::initializer_list<int> squares) {
+  Game game;
+  std::array<bool, 9> marked = {};
+  for (int square : squares) {
+    int move_i = 0;
+    for (int i = 0; i < square; ++i) {
+      if (!marked[i]) ++move_i;
+    }
+    game.MakeMove(move_i);
+    marked[square] = true;
+  }
+  return game;
+}
+
+// The move the search policy of move is one-hot on.
+int BestMoveI(const Game& game, const self_play::MoveOutcome<Game>& move) {
+  for (int move_i = 0; move_i < game.CurrentMovesN(); ++move_i) {
+    if (game.PolicyForMoveI(move.search_policy, move_i) == 1.0f) {
+      return move_i;
+    }
+  }
+  ADD_FAILURE() << "The search policy isn't one-hot.";
+  return -1;
+}
+
+TEST(AlphaBetaTest, TakesWin) {
+  // X has two of the top row and O two of the middle row.
+  Game game = Play({0, 3, 1, 4});
+  GameNetwork network;
+  Searcher<Game, GameNetwork> searcher({.max_depth = 1});
+  Game next_game(game);
+  next_game.MakeMove(BestMoveI(game, searcher.Search(game, &network)));
+  ASSERT_EQ(next_game.State(), games::GameState::kOver);
+  EXPECT_EQ(next_game.Outcome()[game.CurrentPlayerI()], 1.0f);
+}
+
+TEST(AlphaBetaTest, BlocksLoss) {
+  // X threatens the right of the top row.
+  Game game = Play({0, 4, 1});
+  GameNetwork network;
+  Searcher<Game, GameNetwork> searcher({.max_depth = 2});
+  Game next_game(game);
+  next_game.MakeMove(BestMoveI(game, searcher.Search(game, &network)));
+  for (int move_i = 0; move_i < next_game.CurrentMovesN(); ++move_i) {
+    Game reply_game(next_game);
+    reply_game.MakeMove(move_i);
+    EXPECT_EQ(reply_game.State(), games::GameState::kOngoing);
+  }
+}
+
+TEST(AlphaBetaTest, TranspositionsDontChangeMove) {
+  GameNetwork network;
+  Searcher<Game, GameNetwork> with_table({.max_depth = 9});
+  Searcher<Game, GameNetwork> without_table(
+      {.max_depth = 9, .transpositions_n = 0});
+  // Positions with a single best move.
+  for (const Game& game : {Play({0, 3, 1, 4}), Play({0, 4, 1})}) {
+    EXPECT_EQ(BestMoveI(game, with_table.Search(game, &network)),
+              BestMoveI(game, without_table.Search(game, &network)));
+  }
+}
+
+TEST(AlphaBetaTest, ClearsTranspositionsOnceWeightsChange) {
+  Game game = Play({4});
+  GameNetwork network;
+  Searcher<Game, GameNetwork> searcher({.max_depth = 4});
+  searcher.Search(game, &network);
+  std::size_t nodes_n = searcher.nodes_n();
+  searcher.Search(game, &network);
+  EXPECT_LT(searcher.nodes_n(), nodes_n);
+
+  // Variables that can be written through count as changed.
+  std::vector<nn::DynamicMatrixRef> variables;
+  network.GetVariables({}, variables);
+  searcher.Search(game, &network);
+  EXPECT_EQ(searcher.nodes_n(), nodes_n);
+}
+
+TEST(AlphaBetaTest, CompletesFirstIterationPastTimeLimit) {
+  Game game;
+  GameNetwork network;
+  Searcher<Game, GameNetwork> searcher(
+      {.max_depth = 9, .time_limit = std::chrono::microseconds(1)});
+  BestMoveI(game, searcher.Search(game, &network));
+  EXPECT_EQ(searcher.depth_n(), 1);
+}
+
+}  // namespace
+}  // namespace alpha_beta
+}  // namespace mcts
+}  // namespace azah
@@ -13,9 +13,32 @@ class CallbacksBase {
  public:
   virtual void PreSearch(int replica_i) {}
   virtual void PostSearch(int replica_i, std::size_t current_moves_n) {}
+  // Called before PostSearch when a search stopped early because its most
+  // visited move couldn't be overtaken (see self_play::Config::early_stop),
+  // with the number of simulations it didn't need to run. Searches cut short
+  // by their other limits don't count.
+  virtual void SimulationsSaved(int replica_i, std::size_t simulations_n) {}
+  // Called before PostSearch when a forced move wasn't searched at all, with
+  // the number of simulations its search would have run.
+  virtual void SearchSkipped(int replica_i, std::size_t simulations_n) {}
+  // Called before PostSearch with the number of forced states a search added
+  // to its tree without evaluating them.
+  virtual void ForcedMovesCollapsed(int replica_i, std::size_t states_n) {}
+  // Called before PostSearch when a move was played from the opening cache
+  // rather than searched, with the number of simulations its search would
+  // have run.
+  virtual void OpeningCacheHit(int replica_i, std::size_t simulations_n) {}
 
   virtual void PreGame(int replica_i) {}
   virtual void PostGame(int replica_i, std::size_t total_moves_n) {}
+  // Called before PostGame when a game ended by resignation.
+  virtual void GameResigned(int replica_i) {}
+  // Called before PostGame when a game that would have been resigned was
+  // played out, with whether the resignation would have been false: whether
+  // the player who would have resigned did strictly better than losing, which
+  // is all that resigning scores them. A draw or a share of the outcome
+  // counts as much as a win.
+  virtual void ResignationPlayedOut(int replica_i, bool false_resignation) {}
 
   virtual void PreUpdate(int replica_i) {}
   virtual void PostUpdate(int replica_i, std::size_t total_updates_n) {}
@@ -40,6 +63,22 @@ class ReplicaCallbacks {
     callbacks_.PostSearch(replica_i_, current_moves_n);
   }
 
+  void SimulationsSaved(std::size_t simulations_n) {
+    callbacks_.SimulationsSaved(replica_i_, simulations_n);
+  }
+
+  void SearchSkipped(std::size_t simulations_n) {
+    callbacks_.SearchSkipped(replica_i_, simulations_n);
+  }
+
+  void ForcedMovesCollapsed(std::size_t states_n) {
+    callbacks_.ForcedMovesCollapsed(replica_i_, states_n);
+  }
+
+  void OpeningCacheHit(std::size_t simulations_n) {
+    callbacks_.OpeningCacheHit(replica_i_, simulations_n);
+  }
+
   void PreGame() {
     callbacks_.PreGame(replica_i_);
   }
@@ -48,6 +87,14 @@ class ReplicaCallbacks {
     callbacks_.PostGame(replica_i_, total_moves_n);
   }
 
+  void GameResigned() {
+    callbacks_.GameResigned(replica_i_);
+  }
+
+  void ResignationPlayedOut(bool false_resignation) {
+    callbacks_.ResignationPlayedOut(replica_i_, false_resignation);
+  }
+
   void PreUpdate() {
     callbacks_.PreUpdate(replica_i_);
   }
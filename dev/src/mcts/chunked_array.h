@@ -0,0 +1,185 @@
+#ifndef AZAH_MCTS_CHUNKED_ARRAY_H_
+#define AZAH_MCTS_CHUNKED_ARRAY_H_
+
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+
+// A set of append-only parallel arrays ("columns", one per type in Ts) that
+// share an index space. Elements never move once constructed, so they can be
+// read by one thread while another thread appends.
+//
+// Storage is a list of chunks that double in size, which keeps the chunk index
+// cheap to compute and the list short. Each chunk holds a run of every column.
+// Ranges handed out by Allocate are always contiguous in memory within each
+// column; if a range doesn't fit at the end of a chunk, the tail of that chunk
+// is skipped. As a result, indices are not dense.
+template <typename... Ts>
+class ChunkedArray {
+ public:
+  template <std::size_t ColumnI>
+  using Column = std::tuple_element_t<ColumnI, std::tuple<Ts...>>;
+
+  ChunkedArray(const ChunkedArray&) = delete;
+  ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+  ChunkedArray() : next_i_(0), size_(0) {
+    chunks_.fill({});
+    used_n_.fill(0);
+  }
+
+  ~ChunkedArray() {
+    clear();
+    for (std::size_t chunk_i = 0; chunk_i < kMaxChunks; ++chunk_i) {
+      std::apply([](auto*... columns) { (DeallocateColumn(columns), ...); },
+                 chunks_[chunk_i]);
+    }
+  }
+
+  // Only valid for indices whose element has been constructed.
+  template <std::size_t ColumnI>
+  Column<ColumnI>& get(std::size_t i) {
+    auto [chunk_i, offset] = Locate(i);
+    return std::get<ColumnI>(chunks_[chunk_i])[offset];
+  }
+
+  template <std::size_t ColumnI>
+  const Column<ColumnI>& get(std::size_t i) const {
+    auto [chunk_i, offset] = Locate(i);
+    return std::get<ColumnI>(chunks_[chunk_i])[offset];
+  }
+
+  // Reserves n contiguous slots and returns the index of the first. Each slot
+  // of every column must then be constructed with Emplace before clear() is
+  // called.
+  //
+  // Thread safe.
+  std::size_t Allocate(std::size_t n) {
+    std::lock_guard<std::mutex> lock(allocate_m_);
+    auto [chunk_i, offset] = Locate(next_i_);
+    if (offset + n > ChunkSize(chunk_i)) {
+      ++chunk_i;
+      offset = 0;
+      next_i_ = ChunkStart(chunk_i);
+    }
+    if (n > ChunkSize(chunk_i)) {
+      LOG(FATAL) << "Allocation of " << n << " elements is too large.";
+    }
+    if (std::get<0>(chunks_[chunk_i]) == nullptr) {
+      std::apply(
+          [chunk_i](auto*&... columns) {
+            (AllocateColumn(columns, ChunkSize(chunk_i)), ...);
+          },
+          chunks_[chunk_i]);
+    }
+    std::size_t first_i = next_i_;
+    next_i_ += n;
+    used_n_[chunk_i] = offset + n;
+    size_.fetch_add(n, std::memory_order_relaxed);
+    return first_i;
+  }
+
+  // Constructs an element of a column in a slot returned by Allocate.
+  template <std::size_t ColumnI, typename... Args>
+  Column<ColumnI>& Emplace(std::size_t i, Args&&... args) {
+    return *(new (&get<ColumnI>(i)) Column<ColumnI>(
+        std::forward<Args>(args)...));
+  }
+
+  // The number of allocated elements. Thread safe.
+  std::size_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // One past the greatest index allocated so far.
+  std::size_t index_bound() const {
+    return next_i_;
+  }
+
+  // Destroys every element, keeping the chunks around for re-use.
+  //
+  // Not thread safe.
+  void clear() {
+    for (std::size_t chunk_i = 0; chunk_i < kMaxChunks; ++chunk_i) {
+      std::size_t used_n = used_n_[chunk_i];
+      std::apply(
+          [used_n](auto*... columns) {
+            (DestroyColumn(columns, used_n), ...);
+          },
+          chunks_[chunk_i]);
+      used_n_[chunk_i] = 0;
+    }
+    next_i_ = 0;
+    size_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  // The first chunk holds this many elements, and each chunk after holds twice
+  // as many as the last.
+  static constexpr std::size_t kFirstChunkSize = 1024;
+  static constexpr std::size_t kMaxChunks = 32;
+
+  static constexpr std::size_t ChunkSize(std::size_t chunk_i) {
+    return kFirstChunkSize << chunk_i;
+  }
+
+  static constexpr std::size_t ChunkStart(std::size_t chunk_i) {
+    return kFirstChunkSize * ((std::size_t(1) << chunk_i) - 1);
+  }
+
+  static inline std::pair<std::size_t, std::size_t> Locate(std::size_t i) {
+    std::size_t chunk_i = std::bit_width(i / kFirstChunkSize + 1) - 1;
+    return {chunk_i, i - ChunkStart(chunk_i)};
+  }
+
+  template <typename T>
+  static void AllocateColumn(T*& column, std::size_t n) {
+    column = static_cast<T*>(
+        ::operator new(sizeof(T) * n, std::align_val_t(alignof(T))));
+  }
+
+  template <typename T>
+  static void DeallocateColumn(T* column) {
+    if (column == nullptr) return;
+    ::operator delete(column, std::align_val_t(alignof(T)));
+  }
+
+  template <typename T>
+  static void DestroyColumn(T* column, std::size_t n) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (std::size_t i = 0; i < n; ++i) column[i].~T();
+    }
+  }
+
+  std::array<std::tuple<Ts*...>, kMaxChunks> chunks_;
+  // The number of slots handed out from the front of each chunk.
+  std::array<std::size_t, kMaxChunks> used_n_;  // GUARDED_BY(allocate_m_)
+
+  std::mutex allocate_m_;
+  std::size_t next_i_;  // GUARDED_BY(allocate_m_)
+  // Written under allocate_m_, but read freely.
+  std::atomic<std::size_t> size_;
+};
+
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_CHUNKED_ARRAY_H_
@@ -0,0 +1,114 @@
+#include "chunked_array.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+namespace {
+
+// The size of the array's first chunk.
+constexpr std::size_t kFirstChunkSize = 1024;
+
+TEST(ChunkedArrayTest, ColumnsShareIndices) {
+  ChunkedArray<int, float> array;
+  std::size_t first_i = array.Allocate(3);
+  for (std::size_t i = first_i; i < first_i + 3; ++i) {
+    array.Emplace<0>(i, static_cast<int>(i));
+    array.Emplace<1>(i, 0.5f * i);
+  }
+  EXPECT_EQ(array.size(), 3u);
+  for (std::size_t i = first_i; i < first_i + 3; ++i) {
+    EXPECT_EQ(array.get<0>(i), static_cast<int>(i));
+    EXPECT_EQ(array.get<1>(i), 0.5f * i);
+  }
+}
+
+TEST(ChunkedArrayTest, SkipsChunkTailsRangesDontFit) {
+  ChunkedArray<int> array;
+  EXPECT_EQ(array.Allocate(kFirstChunkSize - 10), 0u);
+  // Doesn't fit in the rest of the first chunk, so starts the second.
+  EXPECT_EQ(array.Allocate(20), kFirstChunkSize);
+  EXPECT_EQ(array.Allocate(5), kFirstChunkSize + 20);
+  EXPECT_EQ(array.size(), kFirstChunkSize + 15);
+  EXPECT_EQ(array.index_bound(), kFirstChunkSize + 25);
+  for (std::size_t i = 0; i < kFirstChunkSize - 10; ++i) array.Emplace<0>(i);
+  for (std::size_t i = kFirstChunkSize; i < kFirstChunkSize + 25; ++i) {
+    array.Emplace<0>(i);
+  }
+}
+
+TEST(ChunkedArrayTest, ElementsDontMove) {
+  ChunkedArray<int> array;
+  std::size_t first_i = array.Allocate(1);
+  int* first = &array.Emplace<0>(first_i, 7);
+  for (std::size_t n = 0; n < 8 * kFirstChunkSize; ++n) {
+    array.Emplace<0>(array.Allocate(1), 0);
+  }
+  EXPECT_EQ(&array.get<0>(first_i), first);
+  EXPECT_EQ(*first, 7);
+}
+
+TEST(ChunkedArrayTest, ClearDestroysElements) {
+  auto value = std::make_shared<int>(1);
+  ChunkedArray<std::shared_ptr<int>> array;
+  std::size_t first_i = array.Allocate(4);
+  for (std::size_t i = first_i; i < first_i + 4; ++i) {
+    array.Emplace<0>(i, value);
+  }
+  EXPECT_EQ(value.use_count(), 5);
+  array.clear();
+  EXPECT_EQ(value.use_count(), 1);
+  EXPECT_TRUE(array.empty());
+  EXPECT_EQ(array.Allocate(1), 0u);
+  array.Emplace<0>(0, value);
+}
+
+TEST(ChunkedArrayTest, ConcurrentAllocationsDontOverlap) {
+  constexpr int kThreadsN = 8;
+  constexpr int kAllocationsN = 2000;
+  ChunkedArray<int> array;
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> ranges(
+      kThreadsN);
+  std::vector<std::thread> threads;
+  for (int thread_i = 0; thread_i < kThreadsN; ++thread_i) {
+    threads.emplace_back([&array, &ranges, thread_i] {
+          for (int allocation_i = 0; allocation_i < kAllocationsN;
+               ++allocation_i) {
+            std::size_t n = 1 + (allocation_i + thread_i) % 7;
+            std::size_t first_i = array.Allocate(n);
+            for (std::size_t i = first_i; i < first_i + n; ++i) {
+              array.Emplace<0>(i, thread_i);
+            }
+            ranges[thread_i].push_back({first_i, n});
+          }
+        });
+  }
+  for (auto& thread : threads) thread.join();
+
+  std::size_t size = 0;
+  std::vector<bool> used(array.index_bound(), false);
+  for (int thread_i = 0; thread_i < kThreadsN; ++thread_i) {
+    for (auto [first_i, n] : ranges[thread_i]) {
+      size += n;
+      for (std::size_t i = first_i; i < first_i + n; ++i) {
+        ASSERT_FALSE(used[i]);
+        used[i] = true;
+        EXPECT_EQ(array.get<0>(i), thread_i);
+      }
+    }
+  }
+  EXPECT_EQ(array.size(), size);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
@@ -0,0 +1,119 @@
+#ifndef AZAH_MCTS_EVALUATION_CACHE_H_
+#define AZAH_MCTS_EVALUATION_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <mutex>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+
+// A bounded map from a game state hash and the version of the network that
+// evaluated it (see nn::Network::version) to that evaluation, so a state seen
+// again by the same weights skips the forward pass. Entries made by older
+// weights are never returned again and simply age out.
+//
+// Like TranspositionTable, the map is split into shards with their own locks.
+// Each shard keeps two generations of entries: new entries go into the
+// current one, and once that's full the previous generation is dropped and
+// the current one takes its place. Hits in the previous generation are moved
+// to the current one, so entries in use survive.
+template <typename Evaluation>
+class EvaluationCache {
+ public:
+  EvaluationCache(const EvaluationCache&) = delete;
+  EvaluationCache& operator=(const EvaluationCache&) = delete;
+
+  EvaluationCache() : generation_n_(0) {}
+
+  // Holds at most about entries_n evaluations, or none if 0. Changing the size
+  // drops every entry.
+  //
+  // Not thread safe.
+  void set_size(std::size_t entries_n) {
+    std::size_t generation_n = (entries_n + 2 * kShardsN - 1) / (2 * kShardsN);
+    if (generation_n == generation_n_) return;
+    clear();
+    generation_n_ = generation_n;
+  }
+
+  bool enabled() const {
+    return generation_n_ != 0;
+  }
+
+  // Copies the evaluation of the state with hash by the network version into
+  // evaluation. Returns false if there isn't one.
+  //
+  // Thread safe.
+  bool Find(uint64_t hash, uint64_t version, Evaluation& evaluation) {
+    Shard& shard = shards_[ShardI(hash)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    Key key(hash, version);
+    if (auto iter = shard.current.find(key); iter != shard.current.end()) {
+      evaluation = iter->second;
+      return true;
+    }
+    auto iter = shard.previous.find(key);
+    if (iter == shard.previous.end()) return false;
+    evaluation = iter->second;
+    Evaluation moved = std::move(iter->second);
+    shard.previous.erase(iter);
+    Insert(shard, key, std::move(moved));
+    return true;
+  }
+
+  // Thread safe.
+  void Add(uint64_t hash, uint64_t version, const Evaluation& evaluation) {
+    Shard& shard = shards_[ShardI(hash)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    Insert(shard, Key(hash, version), evaluation);
+  }
+
+  // Not thread safe.
+  void clear() {
+    for (auto& shard : shards_) {
+      shard.current.clear();
+      shard.previous.clear();
+    }
+  }
+
+ private:
+  static constexpr std::size_t kShardsN = 16;
+
+  using Key = std::pair<uint64_t, uint64_t>;
+  using Map = absl::flat_hash_map<Key, Evaluation>;
+
+  struct Shard {
+    std::mutex m;
+    Map current;  // GUARDED_BY(m)
+    Map previous;  // GUARDED_BY(m)
+  };
+  std::array<Shard, kShardsN> shards_;
+
+  // The most entries a generation of a shard holds.
+  std::size_t generation_n_;
+
+  void Insert(Shard& shard, Key key, Evaluation evaluation) {
+    if (shard.current.size() >= generation_n_) {
+      std::swap(shard.previous, shard.current);
+      shard.current.clear();
+    }
+    shard.current.insert_or_assign(key, std::move(evaluation));
+  }
+
+  static inline std::size_t ShardI(uint64_t hash) {
+    return hash >> 60;
+  }
+};
+
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_EVALUATION_CACHE_H_
@@ -0,0 +1,124 @@
+#include "evaluation_cache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+namespace {
+
+using Cache = EvaluationCache<int>;
+
+// The cache's shard count: a size of kShardsN * 2 gives each shard
+// generations of one entry.
+constexpr std::size_t kShardsN = 16;
+
+// Hashes that all land in the first shard.
+constexpr uint64_t kHashA = 1;
+constexpr uint64_t kHashB = 2;
+constexpr uint64_t kHashC = 3;
+
+TEST(EvaluationCacheTest, FindsAddedEntries) {
+  Cache cache;
+  cache.set_size(1024);
+  ASSERT_TRUE(cache.enabled());
+  cache.Add(kHashA, 7, 42);
+  int evaluation = 0;
+  EXPECT_TRUE(cache.Find(kHashA, 7, evaluation));
+  EXPECT_EQ(evaluation, 42);
+  EXPECT_FALSE(cache.Find(kHashB, 7, evaluation));
+}
+
+TEST(EvaluationCacheTest, DisabledAtSizeZero) {
+  Cache cache;
+  EXPECT_FALSE(cache.enabled());
+  cache.set_size(1024);
+  cache.set_size(0);
+  EXPECT_FALSE(cache.enabled());
+}
+
+TEST(EvaluationCacheTest, OtherVersionsMiss) {
+  Cache cache;
+  cache.set_size(1024);
+  cache.Add(kHashA, 7, 42);
+  int evaluation = 0;
+  EXPECT_FALSE(cache.Find(kHashA, 8, evaluation));
+  cache.Add(kHashA, 8, 43);
+  EXPECT_TRUE(cache.Find(kHashA, 8, evaluation));
+  EXPECT_EQ(evaluation, 43);
+  EXPECT_TRUE(cache.Find(kHashA, 7, evaluation));
+  EXPECT_EQ(evaluation, 42);
+}
+
+TEST(EvaluationCacheTest, DropsOldestGeneration) {
+  Cache cache;
+  cache.set_size(2 * kShardsN);
+  int evaluation = 0;
+  cache.Add(kHashA, 0, 1);
+  // A's generation becomes the previous one.
+  cache.Add(kHashB, 0, 2);
+  EXPECT_TRUE(cache.Find(kHashA, 0, evaluation));
+  EXPECT_TRUE(cache.Find(kHashB, 0, evaluation));
+  // A's generation is dropped.
+  cache.Add(kHashC, 0, 3);
+  EXPECT_FALSE(cache.Find(kHashA, 0, evaluation));
+  EXPECT_TRUE(cache.Find(kHashC, 0, evaluation));
+  EXPECT_EQ(evaluation, 3);
+}
+
+TEST(EvaluationCacheTest, HitsSurviveGenerations) {
+  Cache cache;
+  cache.set_size(2 * kShardsN);
+  int evaluation = 0;
+  cache.Add(kHashA, 0, 1);
+  cache.Add(kHashB, 0, 2);
+  // The hit moves A to the current generation, and B to the previous one.
+  EXPECT_TRUE(cache.Find(kHashA, 0, evaluation));
+  cache.Add(kHashC, 0, 3);
+  EXPECT_TRUE(cache.Find(kHashA, 0, evaluation));
+  EXPECT_EQ(evaluation, 1);
+  EXPECT_FALSE(cache.Find(kHashB, 0, evaluation));
+}
+
+TEST(EvaluationCacheTest, ResizingDropsEntries) {
+  Cache cache;
+  cache.set_size(1024);
+  cache.Add(kHashA, 0, 1);
+  cache.set_size(1024);
+  int evaluation = 0;
+  EXPECT_TRUE(cache.Find(kHashA, 0, evaluation));
+  cache.set_size(2048);
+  EXPECT_FALSE(cache.Find(kHashA, 0, evaluation));
+}
+
+TEST(EvaluationCacheTest, SharedAcrossThreads) {
+  constexpr int kThreadsN = 4;
+  constexpr uint64_t kHashesN = 1000;
+  Cache cache;
+  cache.set_size(1 << 16);
+  std::vector<std::thread> threads;
+  for (int thread_i = 0; thread_i < kThreadsN; ++thread_i) {
+    threads.emplace_back([&cache, thread_i] {
+          for (uint64_t i = 0; i < kHashesN; ++i) {
+            // Spread the hashes over the shards.
+            uint64_t hash = (i * 0x9e3779b97f4a7c15ull) ^ thread_i;
+            cache.Add(hash, 0, static_cast<int>(i));
+            int evaluation = -1;
+            EXPECT_TRUE(cache.Find(hash, 0, evaluation));
+            EXPECT_EQ(evaluation, static_cast<int>(i));
+          }
+        });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
@@ -0,0 +1,228 @@
+#ifndef AZAH_MCTS_INFERENCE_SERVICE_H_
+#define AZAH_MCTS_INFERENCE_SERVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+
+// Evaluates inputs for many threads with a few networks. Callers queue an
+// input and get a future for its output; a service thread per network takes
+// up to max_batch_n queued inputs at a time, waiting at most max_wait after
+// the oldest of them arrived for a batch to fill, and evaluates them together
+// with its network.
+//
+// Threads that queue inputs can register as producers (see Producer) and
+// collect their outputs with Wait. Once every registered producer is waiting,
+// nothing more can join the queued inputs, so they're evaluated at once
+// rather than after max_wait.
+//
+// This lets any number of search threads share the networks instead of each
+// driving its own, and gives a batched forward pass one place to go.
+template <typename Input, typename Output, typename Network>
+class InferenceService {
+ public:
+  // Evaluates inputs with network into outputs, which has the same size.
+  using BatchFn = std::function<void(Network* network,
+                                     std::span<const Input> inputs,
+                                     std::span<Output> outputs)>;
+
+  struct Stats {
+    // The number of inputs evaluated, and the batches they were evaluated in.
+    uint64_t requests_n;
+    uint64_t batches_n;
+
+    // The number of inputs waiting now, and the most there have ever been.
+    std::size_t queue_depth;
+    std::size_t max_queue_depth;
+
+    // The mean fraction of max_batch_n that batches were filled to.
+    float batch_fill;
+  };
+
+  InferenceService(const InferenceService&) = delete;
+  InferenceService& operator=(const InferenceService&) = delete;
+
+  // The networks must hold the same weights, and aren't to be used by anyone
+  // else while the service is evaluating.
+  InferenceService(const std::vector<Network*>& networks, BatchFn batch_fn,
+                   std::size_t max_batch_n, std::chrono::microseconds max_wait) :
+      batch_fn_(std::move(batch_fn)), max_batch_n_(max_batch_n),
+      max_wait_(max_wait), exit_(false), producers_n_(0), waiting_n_(0),
+      requests_n_(0), batches_n_(0), max_queue_depth_(0) {
+    if (networks.empty() || (max_batch_n < 1)) {
+      LOG(FATAL) << "An inference service needs a network and a batch size.";
+    }
+    for (Network* network : networks) {
+      threads_.emplace_back([this, network] { Serve(network); });
+    }
+  }
+
+  // Evaluates whatever is still queued before returning.
+  ~InferenceService() {
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      exit_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+  }
+
+  // Registers the calling thread as a producer of inputs for as long as it
+  // lives. Does nothing if service is null.
+  class Producer {
+   public:
+    Producer(const Producer&) = delete;
+    Producer& operator=(const Producer&) = delete;
+
+    explicit Producer(InferenceService* service) : service_(service) {
+      if (service_ == nullptr) return;
+      std::lock_guard<std::mutex> lock(service_->m_);
+      ++(service_->producers_n_);
+    }
+
+    ~Producer() {
+      if (service_ == nullptr) return;
+      {
+        std::lock_guard<std::mutex> lock(service_->m_);
+        --(service_->producers_n_);
+      }
+      // The producers left may all be waiting.
+      service_->cv_.notify_all();
+    }
+
+   private:
+    InferenceService* const service_;
+  };
+
+  // Thread safe.
+  std::future<Output> Evaluate(Input input) {
+    std::future<Output> output;
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      queue_.push_back({std::move(input), std::promise<Output>(),
+                        std::chrono::steady_clock::now()});
+      output = queue_.back().output.get_future();
+      max_queue_depth_ = std::max(max_queue_depth_, queue_.size());
+    }
+    cv_.notify_all();
+    return output;
+  }
+
+  // Returns the output of a future from Evaluate, counting the calling
+  // producer as waiting until it's ready.
+  //
+  // Thread safe.
+  Output Wait(std::future<Output>& output) {
+    if (output.wait_for(std::chrono::seconds::zero())
+        != std::future_status::ready) {
+      {
+        std::lock_guard<std::mutex> lock(m_);
+        ++waiting_n_;
+      }
+      cv_.notify_all();
+      output.wait();
+      std::lock_guard<std::mutex> lock(m_);
+      --waiting_n_;
+    }
+    return output.get();
+  }
+
+  // Thread safe.
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return {
+        .requests_n = requests_n_,
+        .batches_n = batches_n_,
+        .queue_depth = queue_.size(),
+        .max_queue_depth = max_queue_depth_,
+        .batch_fill = (batches_n_ == 0)
+            ? 0.0f
+            : static_cast<float>(requests_n_)
+                / static_cast<float>(batches_n_ * max_batch_n_)};
+  }
+
+ private:
+  struct Request {
+    Input input;
+    std::promise<Output> output;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  const BatchFn batch_fn_;
+  const std::size_t max_batch_n_;
+  const std::chrono::microseconds max_wait_;
+
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  bool exit_;  // GUARDED_BY(m_)
+  std::size_t producers_n_;  // GUARDED_BY(m_)
+  std::size_t waiting_n_;  // GUARDED_BY(m_)
+  std::deque<Request> queue_;  // GUARDED_BY(m_)
+  uint64_t requests_n_;  // GUARDED_BY(m_)
+  uint64_t batches_n_;  // GUARDED_BY(m_)
+  std::size_t max_queue_depth_;  // GUARDED_BY(m_)
+
+  std::vector<std::thread> threads_;
+
+  void Serve(Network* network) {
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<std::promise<Output>> promises;
+    std::unique_lock<std::mutex> lock(m_);
+    for (;;) {
+      cv_.wait(lock, [this] { return exit_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      // Give the batch until the oldest input's wait is up to fill, unless
+      // the service is shutting down or no producer is left to fill it.
+      cv_.wait_until(lock, queue_.front().arrival + max_wait_, [this] {
+            return exit_ || queue_.empty() || (queue_.size() >= max_batch_n_)
+                || ((producers_n_ != 0) && (waiting_n_ >= producers_n_));
+          });
+      // Another thread may have taken the batch.
+      if (queue_.empty()) continue;
+
+      std::size_t batch_n = std::min(queue_.size(), max_batch_n_);
+      inputs.clear();
+      promises.clear();
+      for (std::size_t i = 0; i < batch_n; ++i) {
+        inputs.push_back(std::move(queue_.front().input));
+        promises.push_back(std::move(queue_.front().output));
+        queue_.pop_front();
+      }
+      requests_n_ += batch_n;
+      ++batches_n_;
+      lock.unlock();
+
+      outputs.resize(batch_n);
+      batch_fn_(network, inputs, outputs);
+      for (std::size_t i = 0; i < batch_n; ++i) {
+        promises[i].set_value(std::move(outputs[i]));
+      }
+
+      lock.lock();
+    }
+  }
+};
+
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_INFERENCE_SERVICE_H_
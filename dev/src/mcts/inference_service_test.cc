@@ -0,0 +1,146 @@
+#include "inference_service.h"
+
+#include <stddef.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+namespace {
+
+// A network that adds itself to its inputs.
+using Network = int;
+using Service = InferenceService<int, int, Network>;
+
+// Records the size of every batch evaluated.
+class BatchSizes {
+ public:
+  Service::BatchFn batch_fn() {
+    return [this](Network* network, std::span<const int> inputs,
+                  std::span<int> outputs) {
+          {
+            std::lock_guard<std::mutex> lock(m_);
+            sizes_.push_back(inputs.size());
+          }
+          for (std::size_t i = 0; i < inputs.size(); ++i) {
+            outputs[i] = inputs[i] + *network;
+          }
+        };
+  }
+
+  std::vector<std::size_t> sizes() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return sizes_;
+  }
+
+ private:
+  mutable std::mutex m_;
+  std::vector<std::size_t> sizes_;
+};
+
+constexpr auto kLongWait = std::chrono::seconds(10);
+
+TEST(InferenceServiceTest, FulfilsFutures) {
+  Network network = 100;
+  BatchSizes batch_sizes;
+  Service service({&network}, batch_sizes.batch_fn(), 4,
+                  std::chrono::microseconds(100));
+  std::vector<std::future<int>> outputs;
+  for (int i = 0; i < 10; ++i) outputs.push_back(service.Evaluate(i));
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(service.Wait(outputs[i]), 100 + i);
+
+  Service::Stats stats = service.stats();
+  EXPECT_EQ(stats.requests_n, 10u);
+  EXPECT_EQ(stats.queue_depth, 0u);
+}
+
+TEST(InferenceServiceTest, CoalescesUpToBatchN) {
+  Network network = 0;
+  BatchSizes batch_sizes;
+  Service service({&network}, batch_sizes.batch_fn(), 4, kLongWait);
+  std::vector<std::future<int>> outputs;
+  for (int i = 0; i < 8; ++i) outputs.push_back(service.Evaluate(i));
+  for (auto& output : outputs) output.wait();
+
+  EXPECT_EQ(batch_sizes.sizes(), std::vector<std::size_t>({4, 4}));
+  Service::Stats stats = service.stats();
+  EXPECT_EQ(stats.requests_n, 8u);
+  EXPECT_EQ(stats.batches_n, 2u);
+  EXPECT_GE(stats.max_queue_depth, 4u);
+  EXPECT_FLOAT_EQ(stats.batch_fill, 1.0f);
+}
+
+TEST(InferenceServiceTest, FlushesPartialBatchAfterMaxWait) {
+  Network network = 0;
+  BatchSizes batch_sizes;
+  auto max_wait = std::chrono::milliseconds(20);
+  Service service({&network}, batch_sizes.batch_fn(), 4, max_wait);
+  auto start = std::chrono::steady_clock::now();
+  std::future<int> output = service.Evaluate(1);
+  EXPECT_EQ(output.get(), 1);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, max_wait);
+
+  EXPECT_EQ(batch_sizes.sizes(), std::vector<std::size_t>({1}));
+  EXPECT_FLOAT_EQ(service.stats().batch_fill, 0.25f);
+}
+
+TEST(InferenceServiceTest, FlushesOnceEveryProducerWaits) {
+  Network network = 0;
+  BatchSizes batch_sizes;
+  Service service({&network}, batch_sizes.batch_fn(), 4, kLongWait);
+  auto start = std::chrono::steady_clock::now();
+  {
+    Service::Producer producer(&service);
+    std::future<int> output = service.Evaluate(1);
+    EXPECT_EQ(service.Wait(output), 1);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, kLongWait / 2);
+  EXPECT_EQ(batch_sizes.sizes(), std::vector<std::size_t>({1}));
+}
+
+TEST(InferenceServiceTest, HoldsBatchForProducersStillRunning) {
+  Network network = 0;
+  BatchSizes batch_sizes;
+  Service service({&network}, batch_sizes.batch_fn(), 4, kLongWait);
+  Service::Producer producer(&service);
+  std::thread other([&service] {
+        Service::Producer producer(&service);
+        std::future<int> output = service.Evaluate(1);
+        EXPECT_EQ(service.Wait(output), 1);
+      });
+  // The other producer's input waits for this one.
+  while (service.stats().queue_depth == 0) std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(service.stats().queue_depth, 1u);
+  EXPECT_TRUE(batch_sizes.sizes().empty());
+
+  std::future<int> output = service.Evaluate(2);
+  EXPECT_EQ(service.Wait(output), 2);
+  other.join();
+  EXPECT_EQ(batch_sizes.sizes(), std::vector<std::size_t>({2}));
+  EXPECT_FLOAT_EQ(service.stats().batch_fill, 0.5f);
+}
+
+TEST(InferenceServiceTest, EvaluatesQueuedInputsOnDestruction) {
+  Network network = 0;
+  BatchSizes batch_sizes;
+  std::future<int> output;
+  {
+    Service service({&network}, batch_sizes.batch_fn(), 4, kLongWait);
+    output = service.Evaluate(3);
+  }
+  EXPECT_EQ(output.get(), 3);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
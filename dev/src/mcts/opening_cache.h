@@ -0,0 +1,168 @@
+#ifndef AZAH_MCTS_OPENING_CACHE_H_
+#define AZAH_MCTS_OPENING_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <bit>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "../games/game.h"
+#include "../games/zobrist.h"
+#include "../io/serializable.h"
+#include "absl/container/flat_hash_map.h"
+
+namespace azah {
+namespace mcts {
+namespace self_play {
+
+// The results of deep searches of the positions self-play games start with,
+// so that games reaching one of them can play from the stored result rather
+// than searching it again; see Config::opening_cache.
+//
+// Positions are keyed by what the network sees of them (see Key) rather than
+// by Game::Hash, so states that differ only in what's hidden from the players,
+// like the order of a shuffled deck, share a result.
+//
+// The results are only as good as the weights that searched them, so the
+// cache is tagged with the checkpoint that produced it, and only finds entries
+// for that checkpoint. It's up to whoever holds the cache to rebuild it (see
+// BuildOpeningCache) once the checkpoint they train from has moved on.
+//
+// Finding entries is thread safe, so long as nothing is added at the same
+// time.
+class OpeningCache : public io::Serializable {
+ public:
+  struct Entry {
+    // The proportion of the root's visits each move took, in move order.
+    std::vector<float> policy;
+
+    // The (not rotated) outcome predicted at the root.
+    std::vector<float> outcome;
+  };
+
+  OpeningCache() : checkpoint_(0), plies_n_(0) {}
+
+  // The key of game's state: a hash of its network inputs, its policy class
+  // and its number of moves. Unlike absl::Hash, it's the same in every
+  // process, so keys can be serialized.
+  template <games::AnyGameType Game>
+  static uint64_t Key(const Game& game) {
+    games::ZobristHash hash;
+    hash.Add(game.PolicyClassI());
+    hash.Add(game.CurrentMovesN());
+    for (const auto& input : game.StateToMatrix()) {
+      for (int i = 0; i < input.size(); ++i) {
+        hash.Add(std::bit_cast<int>(input.data()[i]));
+      }
+    }
+    return hash.hash();
+  }
+
+  // Identifies the weights the entries were searched with. What it counts is
+  // up to the caller, a training iteration say.
+  uint64_t checkpoint() const {
+    return checkpoint_;
+  }
+
+  void set_checkpoint(uint64_t checkpoint) {
+    checkpoint_ = checkpoint;
+  }
+
+  // Games only look positions up in their first plies_n moves, which are the
+  // ones the cache was built from.
+  int plies_n() const {
+    return plies_n_;
+  }
+
+  void set_plies_n(int plies_n) {
+    plies_n_ = plies_n;
+  }
+
+  std::size_t size() const {
+    return entries_.size();
+  }
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  void clear() {
+    entries_.clear();
+  }
+
+  // Adds the result for the state with key, replacing any there was.
+  void Add(uint64_t key, Entry entry) {
+    entries_[key] = std::move(entry);
+  }
+
+  // Returns the entry of the state with key, or nullptr if there isn't one
+  // for a state with moves_n moves searched at checkpoint.
+  const Entry* Find(uint64_t key, int moves_n, uint64_t checkpoint) const {
+    if (checkpoint != checkpoint_) return nullptr;
+    auto iter = entries_.find(key);
+    if ((iter == entries_.end())
+        || (iter->second.policy.size() != static_cast<std::size_t>(moves_n))) {
+      return nullptr;
+    }
+    return &(iter->second);
+  }
+
+  void Serialize(std::ostream& out) const override {
+    uint64_t entries_n = entries_.size();
+    out.write(reinterpret_cast<const char*>(&checkpoint_), sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(&plies_n_), sizeof(int));
+    out.write(reinterpret_cast<const char*>(&entries_n), sizeof(uint64_t));
+    for (const auto& [key, entry] : entries_) {
+      out.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+      WriteFloats(entry.policy, out);
+      WriteFloats(entry.outcome, out);
+    }
+  }
+
+  // Replaces the tags and every entry with those read from in.
+  void Deserialize(std::istream& in) override {
+    uint64_t entries_n = 0;
+    in.read(reinterpret_cast<char*>(&checkpoint_), sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(&plies_n_), sizeof(int));
+    in.read(reinterpret_cast<char*>(&entries_n), sizeof(uint64_t));
+    entries_.clear();
+    entries_.reserve(entries_n);
+    for (uint64_t i = 0; i < entries_n; ++i) {
+      uint64_t key;
+      Entry entry;
+      in.read(reinterpret_cast<char*>(&key), sizeof(uint64_t));
+      ReadFloats(in, entry.policy);
+      ReadFloats(in, entry.outcome);
+      entries_[key] = std::move(entry);
+    }
+  }
+
+ private:
+  uint64_t checkpoint_;
+  int plies_n_;
+  absl::flat_hash_map<uint64_t, Entry> entries_;
+
+  static void WriteFloats(const std::vector<float>& values,
+                          std::ostream& out) {
+    uint32_t values_n = values.size();
+    out.write(reinterpret_cast<const char*>(&values_n), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(values.data()),
+              sizeof(float) * values_n);
+  }
+
+  static void ReadFloats(std::istream& in, std::vector<float>& values) {
+    uint32_t values_n = 0;
+    in.read(reinterpret_cast<char*>(&values_n), sizeof(uint32_t));
+    values.resize(values_n);
+    in.read(reinterpret_cast<char*>(values.data()), sizeof(float) * values_n);
+  }
+};
+
+}  // namespace self_play
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_OPENING_CACHE_H_
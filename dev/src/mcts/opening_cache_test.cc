@@ -0,0 +1,68 @@
+#include "opening_cache.h"
+
+#include <stdint.h>
+
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace self_play {
+namespace {
+
+constexpr uint64_t kCheckpoint = 12;
+constexpr uint64_t kKeyA = 0x0123456789abcdefull;
+constexpr uint64_t kKeyB = 0xfedcba9876543210ull;
+
+// A cache at kCheckpoint holding two positions.
+OpeningCache NewCache() {
+  OpeningCache cache;
+  cache.set_checkpoint(kCheckpoint);
+  cache.set_plies_n(4);
+  cache.Add(kKeyA, {.policy = {0.25f, 0.75f}, .outcome = {0.5f, -0.5f}});
+  cache.Add(kKeyB, {.policy = {1.0f, 0.0f, 0.0f}, .outcome = {-1.0f, 1.0f}});
+  return cache;
+}
+
+TEST(OpeningCacheTest, FindsEntriesWithTheirMovesN) {
+  OpeningCache cache = NewCache();
+  const OpeningCache::Entry* entry = cache.Find(kKeyA, 2, kCheckpoint);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->policy, std::vector<float>({0.25f, 0.75f}));
+  EXPECT_EQ(cache.Find(kKeyA, 3, kCheckpoint), nullptr);
+  EXPECT_EQ(cache.Find(kKeyA ^ kKeyB, 2, kCheckpoint), nullptr);
+}
+
+TEST(OpeningCacheTest, OtherCheckpointsMiss) {
+  OpeningCache cache = NewCache();
+  EXPECT_EQ(cache.Find(kKeyA, 2, kCheckpoint + 1), nullptr);
+  EXPECT_EQ(cache.Find(kKeyB, 3, kCheckpoint - 1), nullptr);
+}
+
+TEST(OpeningCacheTest, SerializationRoundTrips) {
+  std::stringstream stream;
+  NewCache().Serialize(stream);
+  OpeningCache cache;
+  cache.Add(kKeyA ^ kKeyB, {.policy = {1.0f}, .outcome = {0.0f, 0.0f}});
+  cache.Deserialize(stream);
+
+  EXPECT_EQ(cache.checkpoint(), kCheckpoint);
+  EXPECT_EQ(cache.plies_n(), 4);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.Find(kKeyA ^ kKeyB, 1, kCheckpoint), nullptr);
+  const OpeningCache::Entry* entry = cache.Find(kKeyB, 3, kCheckpoint);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->policy, std::vector<float>({1.0f, 0.0f, 0.0f}));
+  EXPECT_EQ(entry->outcome, std::vector<float>({-1.0f, 1.0f}));
+
+  // The checkpoint tag is read back with the entries, so they go stale with
+  // it.
+  EXPECT_EQ(cache.Find(kKeyB, 3, kCheckpoint + 1), nullptr);
+}
+
+}  // namespace
+}  // namespace self_play
+}  // namespace mcts
+}  // namespace azah
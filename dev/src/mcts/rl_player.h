@@ -2,9 +2,13 @@
 #define AZAH_MCTS_RL_PLAYER_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -14,13 +18,30 @@
 #include "../nn/adam.h"
 #include "../nn/data_types.h"
 #include "absl/container/flat_hash_map.h"
+#include "alpha_beta.h"
 #include "callbacks.h"
 #include "glog/logging.h"
+#include "opening_cache.h"
 #include "self_play.h"
 #include "work_queue.h"
 
 namespace azah {
 namespace mcts {
+namespace internal {
+
+// An alpha_beta::Searcher of Game, or nothing for games it can't search.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork>
+struct AlphaBetaSearcher {
+  struct type {};
+};
+
+template <alpha_beta::TwoPlayerDeterministicGameType Game,
+          games::GameNetworkType GameNetwork>
+struct AlphaBetaSearcher<Game, GameNetwork> {
+  using type = alpha_beta::Searcher<Game, GameNetwork>;
+};
+
+}  // namespace internal
 
 CallbacksBase default_callbacks;
 
@@ -37,7 +58,7 @@ class RLPlayer : public io::Serializable {
   RLPlayer(std::size_t replicas_n, Callbacks& callbacks = default_callbacks,
            const Options& options = Options()) :
       work_queue_(replicas_n, options.async_dispatch_queue_length) {
-    for (int i = 0; i < replicas_n; ++i) {
+    for (std::size_t i = 0; i < replicas_n; ++i) {
       replica_callbacks_.push_back(ReplicaCallbacks<Callbacks>(i, callbacks));
     }
     ResetInternal(replicas_n);
@@ -76,8 +97,115 @@ class RLPlayer : public io::Serializable {
     // A multiplier on the upper-confidence-bound that encourages exploration
     // when higher.
     float exploration_scale;
+
+    // The number of leaves collected per search round before they're
+    // evaluated together, or 0 for the batch_n of the network's batched
+    // counterpart; see self_play::Config::leaf_batch_n.
+    int leaf_batch_n = 0;
+
+    // The number of threads that grow each replica's search tree together.
+    // Every thread past the first searches with its own copy of the replica's
+    // network.
+    int search_threads_n = 1;
+
+    // The number of independent trees each replica searches when evaluating a
+    // position. Their root statistics are merged, which averages out search
+    // noise in a fraction of the time that repeated evaluations would take.
+    // Each tree searches with search_threads_n networks of its own.
+    int root_trees_n = 1;
+
+    // The most nodes any one search tree may hold, or 0 for no limit. Past
+    // this, the least visited lines of play are forgotten to make room.
+    std::size_t max_tree_nodes_n = 0;
+
+    // If true, root noise is drawn once per searched move rather than at every
+    // visit to the root.
+    bool root_noise_per_move = false;
+
+    // If true, a move's search stops once its most visited move can't be
+    // overtaken; see self_play::Config::early_stop.
+    bool early_stop = false;
+    float early_stop_margin = 1.0f;
+    bool early_stop_carry_over = false;
+
+    // Playout cap randomization for training; see
+    // self_play::Config::full_search_fraction.
+    float full_search_fraction = 1.0f;
+    int fast_simulations_n = 0;
+
+    // Per-move search budgets that cut simulations_n short; see
+    // self_play::Config::search_time_limit. Zero means no limit.
+    std::chrono::microseconds search_time_limit = 
+        std::chrono::microseconds::zero();
+    std::size_t max_search_nodes_n = 0;
+
+    // If true, searches prove exact outcomes where they can; see
+    // self_play::Config::solve.
+    bool solve = false;
+
+    // How many network evaluations each replica caches by game state, in a
+    // cache shared by all of its search trees and sessions; see
+    // self_play::Config::evaluation_cache_n.
+    std::size_t evaluation_cache_n = 0;
+
+    // If not zero, the number of root moves considered by a Gumbel search
+    // rather than PUCT, and the scale of its outcome transform; see
+    // self_play::Config::gumbel_considered_n.
+    int gumbel_considered_n = 0;
+    float gumbel_visit_scale = 50.0f;
+    float gumbel_value_scale = 1.0f;
+
+    // The number of children of each new node to evaluate ahead of their
+    // first visit; see self_play::Config::speculative_children_n.
+    int speculative_children_n = 0;
+
+    // If true, forced moves aren't searched and forced chains are collapsed;
+    // see self_play::Config::skip_forced_moves.
+    bool skip_forced_moves = false;
+
+    // If not zero, the value below which players resign, the number of their
+    // moves in a row it takes, and the fraction of would-be resignations that
+    // are played out anyway; see self_play::Config::resign_threshold.
+    float resign_threshold = 0.0f;
+    int resign_moves_n = 1;
+    float resign_playout_fraction = 0.0f;
+
+    // If set, self-play games play the positions it holds from their cached
+    // results rather than searching them, so long as it's tagged with
+    // opening_checkpoint, the checkpoint the replicas' weights come from; see
+    // BuildOpeningCache and self_play::Config::opening_cache.
+    const self_play::OpeningCache* opening_cache = nullptr;
+    uint64_t opening_checkpoint = 0;
+
+    // If true, search trees replay moves from the root rather than storing a
+    // game in every node; see self_play::Config::open_loop.
+    bool open_loop = false;
+
+    // The number of self-play games each replica plays per training
+    // iteration. More than one are interleaved on the replica's thread, each
+    // suspending while it waits on the network; see
+    // self_play::SelfPlayConcurrently. search_threads_n must then be 1.
+    int concurrent_games_n = 1;
+
+    // If not zero, each replica's searches send their evaluations to an
+    // inference service that batches up to this many of them for a thread of
+    // its own holding the replica's network, waiting at most
+    // inference_max_wait for a batch to fill, or less once every search
+    // thread is waiting on it; see internal::InferenceService. Every search
+    // thread and tree of the replica, in self-play and in sessions alike,
+    // then shares that network rather than each searching with a copy.
+    // Batches run in forward passes of the network's batched counterpart
+    // (see games::GameNetwork::Batched), so a multiple of its batch_n fills
+    // them. Concurrent games don't use the service; they batch their
+    // evaluations across games instead.
+    int inference_batch_n = 0;
+    std::chrono::microseconds inference_max_wait = 
+        std::chrono::microseconds(100);
   };
 
+  using InferenceStats = typename self_play::SearchTree<
+      Game, GameNetwork>::InferenceService::Stats;
+
   struct EvaluateResult {
     // The belief in the outcome of the game. 
     std::array<float, Game::players_n()> predicted_outcome;
@@ -87,6 +215,59 @@ class RLPlayer : public io::Serializable {
     std::vector<float> predicted_move;
   };
 
+  // A search of one game position for every replica that carries over between
+  // calls to Evaluate. After each move is made, the replicas' searches pick up
+  // from the subtree below it rather than starting over.
+  class EvaluateSession {
+   public:
+    // Makes the move at move_i from the current position, where position is
+    // the game state that resulted.
+    void Advance(int move_i, const Game& position) {
+      for (auto& session : replica_sessions_) {
+        session->Advance(move_i, position);
+      }
+    }
+
+    // The position evaluated by the next call to Evaluate.
+    const Game& position() const {
+      return replica_sessions_[0]->game();
+    }
+
+   private:
+    friend class RLPlayer;
+
+    EvaluateSession(const Game& position, const self_play::Config& config, 
+                    std::size_t replicas_n, int inference_batch_n,
+                    std::chrono::microseconds inference_max_wait) :
+        config_(config), inference_batch_n_(inference_batch_n),
+        inference_max_wait_(inference_max_wait) {
+      for (std::size_t i = 0; i < replicas_n; ++i) {
+        replica_sessions_.push_back(
+            std::make_unique<self_play::SearchSession<Game, GameNetwork>>(
+                config_, position));
+      }
+    }
+
+    const self_play::Config config_;
+    const int inference_batch_n_;
+    const std::chrono::microseconds inference_max_wait_;
+    std::vector<std::unique_ptr<self_play::SearchSession<Game, GameNetwork>>> 
+        replica_sessions_;
+  };
+
+  // Begins a session for evaluating position and the positions that follow
+  // it.
+  EvaluateSession NewEvaluateSession(const Game& position,
+                                     const SelfPlayOptions& self_play_options) {
+    if (position.State() == games::GameState::kOver) {
+      LOG(FATAL) << "Game is over.";
+    }
+    return EvaluateSession(
+        position, SelfPlayOptionsToConfig(false, self_play_options), 
+        replicas_.size(), self_play_options.inference_batch_n,
+        self_play_options.inference_max_wait);
+  }
+
   // Evaluate one game position.
   EvaluateResult Evaluate(const Game& position, 
                           const SelfPlayOptions& self_play_options) {
@@ -98,30 +279,98 @@ class RLPlayer : public io::Serializable {
     std::vector<std::vector<self_play::MoveOutcome<Game>>> replica_moves(
         replicas_.size());
     for (int i = 0; i < replicas_.size(); ++i) {
+      replicas_[i]->SetInference(self_play_options.inference_batch_n,
+                                 self_play_options.inference_max_wait);
       work_queue_.AddWork(std::make_unique<ReplicaSelfPlayerFn>(
-          position, self_play_config, &(replicas_[i]->network), 
-          &(replica_moves[i]), replica_callbacks_[i]));
+          position, self_play_config, 
+          replicas_[i]->SelfPlayNetworks(
+              self_play::SearchNetworksN(self_play_config)), 
+          replicas_[i]->tree, &(replica_moves[i]), replica_callbacks_[i]));
     }
     work_queue_.Drain();
 
-    // Average the outcomes and search policies into the first replica.
-    for (std::size_t i = 1; i < replicas_.size(); ++i) {
-      replica_moves[0][0].outcome += replica_moves[i][0].outcome;
-      replica_moves[0][0].search_policy += replica_moves[i][0].search_policy;
+    std::vector<self_play::MoveOutcome<Game>> root_moves;
+    for (auto& moves : replica_moves) root_moves.push_back(std::move(moves[0]));
+    return MergeReplicaMoves(position, root_moves);
+  }
+
+  // Evaluate one game position with an alpha-beta search rather than MCTS;
+  // see alpha_beta::Searcher. Each replica searches with its own network, and
+  // their results are merged as in Evaluate. The predicted move is one-hot on
+  // the best move if there's a single replica.
+  EvaluateResult EvaluateAlphaBeta(const Game& position,
+                                   const alpha_beta::Config& config)
+      requires alpha_beta::TwoPlayerDeterministicGameType<Game> {
+    if (position.State() == games::GameState::kOver) {
+      LOG(FATAL) << "Game is over.";
     }
-    replica_moves[0][0].outcome /= static_cast<float>(replicas_.size());
-    replica_moves[0][0].search_policy /= static_cast<float>(replicas_.size());
 
-    // Copy the results out.
-    EvaluateResult result;
-    for (std::size_t i = 0; i < position.CurrentMovesN(); ++i) {
-      result.predicted_move.push_back(
-          position.PolicyForMoveI(replica_moves[0][0].search_policy, i));
+    std::vector<self_play::MoveOutcome<Game>> root_moves(replicas_.size());
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+      work_queue_.AddWork(std::make_unique<ReplicaAlphaBetaFn<Game>>(
+          position, config, *(replicas_[i]), &(root_moves[i]),
+          replica_callbacks_[i]));
     }
-    for (std::size_t i = 0; i < Game::players_n(); ++i) {
-      result.predicted_outcome[i] = replica_moves[0][0].outcome(i, 0);
+    work_queue_.Drain();
+
+    return MergeReplicaMoves(position, root_moves);
+  }
+
+  // Keeps searching the current position of a session in the background
+  // until the session is next evaluated or advanced, typically while the
+  // opponent chooses their move; see self_play::SearchSession::Ponder. The
+  // replicas' networks are in use until then, so nothing else that searches
+  // or trains may be called in the meantime.
+  //
+  // If simulations_n isn't zero, each search tree stops pondering after that
+  // many simulations.
+  void Ponder(EvaluateSession& session, int simulations_n = 0) {
+    if (session.replica_sessions_.size() != replicas_.size()) {
+      LOG(FATAL) << "Session was created for a different number of replicas.";
     }
-    return result;
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+      session.replica_sessions_[i]->Ponder(
+          SessionNetworks(session, i), simulations_n);
+    }
+  }
+
+  // Evaluate the current position of a session, continuing its searches.
+  EvaluateResult Evaluate(EvaluateSession& session) {
+    if (session.position().State() == games::GameState::kOver) {
+      LOG(FATAL) << "Game is over.";
+    }
+    if (session.replica_sessions_.size() != replicas_.size()) {
+      LOG(FATAL) << "Session was created for a different number of replicas.";
+    }
+
+    std::vector<self_play::MoveOutcome<Game>> root_moves(replicas_.size());
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+      work_queue_.AddWork(std::make_unique<ReplicaSearchFn>(
+          *(session.replica_sessions_[i]), SessionNetworks(session, i),
+          &(root_moves[i]), replica_callbacks_[i]));
+    }
+    work_queue_.Drain();
+
+    return MergeReplicaMoves(session.position(), root_moves);
+  }
+
+  // Builds an opening cache for self-play with the first replica's weights,
+  // tagged with checkpoint: the positions that games_n games would reach at
+  // least min_games_n times in their first plies_n moves are searched as
+  // Evaluate would search them with self_play_options, ignoring
+  // opening_cache; see self_play::BuildOpeningCache.
+  self_play::OpeningCache BuildOpeningCache(
+      int plies_n, int games_n, int min_games_n, uint64_t checkpoint,
+      const SelfPlayOptions& self_play_options) {
+    auto self_play_config = SelfPlayOptionsToConfig(false, self_play_options);
+    self_play_config.opening_cache = nullptr;
+    self_play::OpeningCache cache;
+    self_play::BuildOpeningCache<Game>(
+        self_play_config, plies_n, games_n, min_games_n, checkpoint,
+        replicas_[0]->SearchNetworks(
+            self_play::SearchNetworksN(self_play_config)),
+        replica_callbacks_[0], cache);
+    return cache;
   }
 
   struct TrainResult {
@@ -141,13 +390,24 @@ class RLPlayer : public io::Serializable {
   };
 
   // Train the internal models using self-play.
+  //
+  // Every replica trains on the moves of all the replicas' games, so each
+  // iteration holds all of them in memory until its update: moves are
+  // gathered with a self_play::MoveCollector rather than streamed. To consume
+  // moves as they're made, play with self_play::SelfPlay and a
+  // self_play::MoveSink instead.
   TrainResult Train(int games_n, const SelfPlayOptions& self_play_options) {
     auto self_play_config = SelfPlayOptionsToConfig(true, self_play_options);
+    for (auto& replica : replicas_) {
+      replica->SetInference(self_play_options.inference_batch_n,
+                            self_play_options.inference_max_wait);
+    }
 
     TrainResult losses{0.0f, 0.0f};
     for (int i = 0; i < games_n; ++i) {
       auto iter_losses = TrainIteration(self_play_options.learning_rate,
-                                        self_play_config);
+                                        self_play_config,
+                                        self_play_options.concurrent_games_n);
       losses.policy_loss += iter_losses.policy_loss;
       losses.outcome_loss += iter_losses.outcome_loss;
     }
@@ -161,6 +421,14 @@ class RLPlayer : public io::Serializable {
     ResetInternal(replicas_.size());
   }
 
+  // The statistics of a replica's inference service, if it has one; see
+  // SelfPlayOptions::inference_batch_n.
+  std::optional<InferenceStats> inference_stats(std::size_t replica_i) const {
+    const auto& service = replicas_[replica_i]->inference_service;
+    if (service == nullptr) return std::nullopt;
+    return service->stats();
+  }
+
   void Serialize(std::ostream& out) const override {
     for (const auto& replica: replicas_) {
       replica->network.Serialize(out);
@@ -181,12 +449,122 @@ class RLPlayer : public io::Serializable {
   std::vector<ReplicaCallbacks<Callbacks>> replica_callbacks_;
 
   struct Replica {
-    Replica() : opt(network) {}
+    Replica() : opt(network) {
+      tree.set_evaluation_cache(&evaluation_cache);
+    }
     GameNetwork network;
     nn::Adam opt;
+
+    // Shared by every tree searching with network or its copies, which share
+    // its version; see self_play::Config::evaluation_cache_n.
+    typename self_play::SearchTree<Game, GameNetwork>::EvaluationCache
+        evaluation_cache;
+
+    // Copies of network used by the extra threads of a tree or root-parallel
+    // search.
+    std::vector<std::unique_ptr<GameNetwork>> network_copies;
+
+    // Reused by every alpha-beta search of this replica, so its
+    // transpositions carry over until network's weights change; see
+    // EvaluateAlphaBeta.
+    std::unique_ptr<
+        typename internal::AlphaBetaSearcher<Game, GameNetwork>::type>
+        alpha_beta_searcher;
+
+    // Reused by every self-play game of this replica.
+    self_play::SearchTree<Game, GameNetwork> tree;
+    // Reused by concurrent self-play games, one per game.
+    std::vector<std::unique_ptr<self_play::SearchTree<Game, GameNetwork>>>
+        concurrent_trees;
+
+    // Returns concurrent_trees, with at least trees_n trees.
+    std::vector<std::unique_ptr<self_play::SearchTree<Game, GameNetwork>>>&
+        ConcurrentTrees(int trees_n) {
+      while (concurrent_trees.size() < static_cast<std::size_t>(trees_n)) {
+        concurrent_trees.push_back(
+            std::make_unique<self_play::SearchTree<Game, GameNetwork>>());
+        concurrent_trees.back()->set_evaluation_cache(&evaluation_cache);
+      }
+      return concurrent_trees;
+    }
+
+    // Evaluates for the searches of tree and of sessions, if set, with the
+    // settings it was started with.
+    std::unique_ptr<typename self_play::SearchTree<
+        Game, GameNetwork>::InferenceService> inference_service;
+    int inference_batch_n = 0;
+    std::chrono::microseconds inference_max_wait = 
+        std::chrono::microseconds::zero();
+
+    // Starts, replaces or stops the inference service to match the settings;
+    // see SelfPlayOptions::inference_batch_n.
+    void SetInference(int batch_n, std::chrono::microseconds max_wait) {
+      if ((batch_n == inference_batch_n) 
+          && ((batch_n == 0) || (max_wait == inference_max_wait))) {
+        return;
+      }
+      using Tree = self_play::SearchTree<Game, GameNetwork>;
+      tree.set_inference_service(nullptr);
+      inference_service.reset();
+      inference_batch_n = batch_n;
+      inference_max_wait = max_wait;
+      if (batch_n == 0) return;
+      inference_service = std::make_unique<typename Tree::InferenceService>(
+          std::vector<GameNetwork*>{&network}, 
+          [](GameNetwork* network, std::span<const Game> games,
+             std::span<self_play::internal::Evaluation<Game>> evaluations) {
+                Tree::EvaluateBatchWithNetwork(network, games, evaluations);
+              },
+          batch_n, max_wait);
+      tree.set_inference_service(inference_service.get());
+    }
+
+    // Returns networks_n networks holding the current weights, starting with
+    // network itself.
+    std::vector<GameNetwork*> SearchNetworks(int networks_n) {
+      std::vector<GameNetwork*> networks{&network};
+      if (networks_n <= 1) return networks;
+
+      while (network_copies.size()
+             < static_cast<std::size_t>(networks_n - 1)) {
+        network_copies.push_back(std::make_unique<GameNetwork>());
+      }
+      for (int i = 0; i < (networks_n - 1); ++i) {
+        // Skip copies that are already current, and keep the version shared
+        // so cached evaluations apply to every copy.
+        if (network_copies[i]->version() != network.version()) {
+          network_copies[i]->CopyVariables(network);
+        }
+        networks.push_back(network_copies[i].get());
+      }
+      return networks;
+    }
+
+    // The networks to search tree with: with an inference service, they only
+    // stand for search threads, and the service's network does the work.
+    std::vector<GameNetwork*> SelfPlayNetworks(int networks_n) {
+      if (inference_service == nullptr) return SearchNetworks(networks_n);
+      return std::vector<GameNetwork*>(networks_n, &network);
+    }
   };
   std::vector<std::unique_ptr<Replica>> replicas_;
 
+  // Points the trees of replica_i's session at the replica's evaluation cache
+  // and inference service, started to match the session's settings, and
+  // returns the networks to search them with.
+  std::vector<GameNetwork*> SessionNetworks(EvaluateSession& session,
+                                            std::size_t replica_i) {
+    Replica& replica = *(replicas_[replica_i]);
+    replica.SetInference(session.inference_batch_n_,
+                         session.inference_max_wait_);
+    session.replica_sessions_[replica_i]->set_evaluation_cache(
+        &(replica.evaluation_cache));
+    session.replica_sessions_[replica_i]->set_inference_service(
+        replica.inference_service.get());
+    return replica.SelfPlayNetworks(
+        self_play::SearchNetworksN(session.config_));
+  }
+
   void ResetInternal(std::size_t n) {
     replicas_.clear();
     for (std::size_t i = 0; i < n; ++i) {
@@ -203,32 +581,158 @@ class RLPlayer : public io::Serializable {
         .root_noise_lerp = self_play_options.root_noise_lerp,
         .one_hot_breakover_moves_n = 
             self_play_options.one_hot_breakover_moves_n,
-        .exploration_scale = self_play_options.exploration_scale};
+        .exploration_scale = self_play_options.exploration_scale,
+        .leaf_batch_n = self_play_options.leaf_batch_n,
+        .search_threads_n = self_play_options.search_threads_n,
+        .root_trees_n = self_play_options.root_trees_n,
+        .max_tree_nodes_n = self_play_options.max_tree_nodes_n,
+        .root_noise_per_move = self_play_options.root_noise_per_move,
+        .early_stop = self_play_options.early_stop,
+        .early_stop_margin = self_play_options.early_stop_margin,
+        .early_stop_carry_over = self_play_options.early_stop_carry_over,
+        .full_search_fraction = self_play_options.full_search_fraction,
+        .fast_simulations_n = self_play_options.fast_simulations_n,
+        .search_time_limit = self_play_options.search_time_limit,
+        .max_search_nodes_n = self_play_options.max_search_nodes_n,
+        .solve = self_play_options.solve,
+        .evaluation_cache_n = self_play_options.evaluation_cache_n,
+        .gumbel_considered_n = self_play_options.gumbel_considered_n,
+        .gumbel_visit_scale = self_play_options.gumbel_visit_scale,
+        .gumbel_value_scale = self_play_options.gumbel_value_scale,
+        .speculative_children_n = self_play_options.speculative_children_n,
+        .skip_forced_moves = self_play_options.skip_forced_moves,
+        .resign_threshold = self_play_options.resign_threshold,
+        .resign_moves_n = self_play_options.resign_moves_n,
+        .resign_playout_fraction = self_play_options.resign_playout_fraction,
+        .opening_cache = self_play_options.opening_cache,
+        .opening_checkpoint = self_play_options.opening_checkpoint,
+        .open_loop = self_play_options.open_loop};
   }
 
   class ReplicaSelfPlayerFn : public internal::WorkQueueElement {
    public:
     template <typename GameT>
     ReplicaSelfPlayerFn(GameT&& position, const self_play::Config& config,
-                        GameNetwork* network,
+                        std::vector<GameNetwork*>&& networks,
+                        self_play::SearchTree<Game, GameNetwork>& tree,
                         std::vector<self_play::MoveOutcome<Game>>* moves, 
                         ReplicaCallbacks<Callbacks>& callbacks) :
         position_(std::forward<GameT>(position)), config_(config), 
-        network_(network), moves_(moves), callbacks_(callbacks) {}
+        networks_(std::move(networks)), tree_(tree), moves_(moves), 
+        callbacks_(callbacks) {}
 
     void run() override {
-      *moves_ = std::move(self_play::SelfPlay(config_, position_, network_, 
-                                              callbacks_));
+      *moves_ = std::move(self_play::SelfPlay(config_, position_, networks_, 
+                                              tree_, callbacks_));
     }
 
    private:
     const Game position_;
     const self_play::Config& config_;
-    GameNetwork* network_;
+    const std::vector<GameNetwork*> networks_;
+    self_play::SearchTree<Game, GameNetwork>& tree_;
     std::vector<self_play::MoveOutcome<Game>>* moves_;
     ReplicaCallbacks<Callbacks>& callbacks_;
   };
 
+  class ReplicaConcurrentSelfPlayerFn : public internal::WorkQueueElement {
+   public:
+    ReplicaConcurrentSelfPlayerFn(
+        const self_play::Config& config, int games_n, Replica& replica,
+        std::vector<self_play::MoveOutcome<Game>>* moves,
+        ReplicaCallbacks<Callbacks>& callbacks) :
+        config_(config), games_n_(games_n), replica_(replica), moves_(moves),
+        callbacks_(callbacks) {}
+
+    void run() override {
+      *moves_ = std::move(self_play::SelfPlayConcurrently(
+          config_, Game(), games_n_, &(replica_.network),
+          replica_.ConcurrentTrees(games_n_), callbacks_));
+    }
+
+   private:
+    const self_play::Config& config_;
+    const int games_n_;
+    Replica& replica_;
+    std::vector<self_play::MoveOutcome<Game>>* moves_;
+    ReplicaCallbacks<Callbacks>& callbacks_;
+  };
+
+  class ReplicaSearchFn : public internal::WorkQueueElement {
+   public:
+    ReplicaSearchFn(self_play::SearchSession<Game, GameNetwork>& session,
+                    std::vector<GameNetwork*>&& networks,
+                    self_play::MoveOutcome<Game>* move,
+                    ReplicaCallbacks<Callbacks>& callbacks) :
+        session_(session), networks_(std::move(networks)), move_(move),
+        callbacks_(callbacks) {}
+
+    void run() override {
+      *move_ = session_.Search(networks_, callbacks_);
+    }
+
+   private:
+    self_play::SearchSession<Game, GameNetwork>& session_;
+    const std::vector<GameNetwork*> networks_;
+    self_play::MoveOutcome<Game>* move_;
+    ReplicaCallbacks<Callbacks>& callbacks_;
+  };
+
+  // A template only so that it's never built for games alpha-beta can't
+  // search.
+  template <alpha_beta::TwoPlayerDeterministicGameType SearchedGame>
+  class ReplicaAlphaBetaFn : public internal::WorkQueueElement {
+   public:
+    ReplicaAlphaBetaFn(const SearchedGame& position,
+                       const alpha_beta::Config& config, Replica& replica,
+                       self_play::MoveOutcome<SearchedGame>* move,
+                       ReplicaCallbacks<Callbacks>& callbacks) :
+        position_(position), config_(config), replica_(replica), move_(move),
+        callbacks_(callbacks) {}
+
+    void run() override {
+      callbacks_.PreSearch();
+      auto& searcher = replica_.alpha_beta_searcher;
+      if ((searcher == nullptr) || (searcher->config() != config_)) {
+        searcher = std::make_unique<
+            alpha_beta::Searcher<SearchedGame, GameNetwork>>(config_);
+      }
+      *move_ = searcher->Search(position_, &(replica_.network));
+      callbacks_.PostSearch(0);
+    }
+
+   private:
+    const SearchedGame& position_;
+    const alpha_beta::Config& config_;
+    Replica& replica_;
+    self_play::MoveOutcome<SearchedGame>* move_;
+    ReplicaCallbacks<Callbacks>& callbacks_;
+  };
+
+  // Averages the outcomes and search policies each replica found for position.
+  static EvaluateResult MergeReplicaMoves(
+      const Game& position, 
+      std::vector<self_play::MoveOutcome<Game>>& replica_moves) {
+    // Average the outcomes and search policies into the first replica.
+    for (std::size_t i = 1; i < replica_moves.size(); ++i) {
+      replica_moves[0].outcome += replica_moves[i].outcome;
+      replica_moves[0].search_policy += replica_moves[i].search_policy;
+    }
+    replica_moves[0].outcome /= static_cast<float>(replica_moves.size());
+    replica_moves[0].search_policy /= static_cast<float>(replica_moves.size());
+
+    // Copy the results out.
+    EvaluateResult result;
+    for (int i = 0; i < position.CurrentMovesN(); ++i) {
+      result.predicted_move.push_back(
+          position.PolicyForMoveI(replica_moves[0].search_policy, i));
+    }
+    for (std::size_t i = 0; i < Game::players_n(); ++i) {
+      result.predicted_outcome[i] = replica_moves[0].outcome(i, 0);
+    }
+    return result;
+  }
+
   class ReplicaSGDFn : public internal::WorkQueueElement {
    public:
     ReplicaSGDFn(
@@ -318,15 +822,24 @@ class RLPlayer : public io::Serializable {
   };
 
   TrainResult TrainIteration(
-      float learning_rate, const self_play::Config& self_play_config) {
+      float learning_rate, const self_play::Config& self_play_config,
+      int concurrent_games_n) {
     // This is effectively a nested list of training examples and needs to
     // outlive gradient accumulation for obvious reasons.
     std::vector<std::vector<self_play::MoveOutcome<Game>>> replica_moves(
         replicas_.size());
     for (int i = 0; i < replicas_.size(); ++i) {
+      if (concurrent_games_n > 1) {
+        work_queue_.AddWork(std::make_unique<ReplicaConcurrentSelfPlayerFn>(
+            self_play_config, concurrent_games_n, *(replicas_[i]),
+            &(replica_moves[i]), replica_callbacks_[i]));
+        continue;
+      }
       work_queue_.AddWork(std::make_unique<ReplicaSelfPlayerFn>(
-          Game(), self_play_config, &(replicas_[i]->network), 
-          &(replica_moves[i]), replica_callbacks_[i]));
+          Game(), self_play_config, 
+          replicas_[i]->SelfPlayNetworks(
+              self_play::SearchNetworksN(self_play_config)), 
+          replicas_[i]->tree, &(replica_moves[i]), replica_callbacks_[i]));
     }
     work_queue_.Drain();
 
@@ -337,6 +850,8 @@ class RLPlayer : public io::Serializable {
         all_moves.push_back(&move);
       }
     }
+    // With playout cap randomization, a short game may not record any moves.
+    if (all_moves.empty()) return {0.0f, 0.0f};
     
     // Update the replicas.
     std::vector<TrainResult> replica_losses(replicas_.size(), {0.0f, 0.0f});
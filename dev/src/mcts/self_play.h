@@ -3,382 +3,2878 @@
 
 #include <math.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "../games/game.h"
 #include "../games/game_network.h"
 #include "../nn/data_types.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/random/bit_gen_ref.h"
 #include "absl/random/random.h"
 #include "callbacks.h"
+#include "chunked_array.h"
+#include "evaluation_cache.h"
 #include "glog/logging.h"
+#include "inference_service.h"
+#include "opening_cache.h"
+#include "task.h"
+#include "transposition_table.h"
+#include "work_queue.h"
 
 namespace azah {
 namespace mcts {
 namespace self_play {
+
+struct Config {
+  // The total number of MCTS simulations to perform per-move.
+  //
+  // AlphaZero uses 800.
+  int simulations_n;
+
+  // If true, the game is played to completion from the provided game state.
+  // Otherwise, only the result of searching a single move is returned.
+  bool full_play;
+
+  // The alpha value of Dirichlet noise added to the root search policy. Noise
+  // is generated at every visit to the root, unless root_noise_per_move.
+  //
+  // AlphaZero uses 0.3 for chess.
+  float root_noise_alpha;
+
+  // The amount interpolated between the predicted root policy and root noise.
+  //
+  // AlphaZero uses 0.25.
+  float root_noise_lerp;
+
+  // One-hot policy breakover threshold: the number of moves after which the
+  // search policies returned from self-play are just one-hot of the maximum
+  // valued move. If !full_play, the root search policy is never converted to
+  // one-hot.
+  //
+  // AlphaZero uses 30.
+  int one_hot_breakover_moves_n;
+
+  // A multiplier on the upper-confidence-bound that encourages exploration when
+  // higher.
+  float exploration_scale;
+
+  // The number of leaves collected per search round before they're evaluated
+  // together, in full batches of the network's batched counterpart where there
+  // is one (see games::GameNetwork::Batched). Virtual loss on the traversed
+  // edges steers the descents of a round apart. 1 reproduces classic
+  // one-leaf-at-a-time search.
+  //
+  // If 0, the batch_n of the network's batched counterpart, or 1 if there's
+  // none; see LeafBatchN. Leaves short of a full batch are evaluated one at a
+  // time, since a batched pass costs about as much as batch_n single ones, so
+  // other sizes waste the batched network.
+  int leaf_batch_n = 0;
+
+  // The number of threads that grow the search tree together. Each thread
+  // needs its own copy of the network. The threads past the calling one are
+  // kept by the tree from one search to the next, since starting them for
+  // every search would cost tens of microseconds each: a lot next to a fast
+  // search.
+  int search_threads_n = 1;
+
+  // If !full_play, the number of independent trees that search the position,
+  // each on its own thread with its own random stream. Their root visit counts
+  // and outcomes are merged into the single move returned, which cuts the
+  // variance of the search policy without searching any one tree for longer.
+  int root_trees_n = 1;
+
+  // The most nodes a search tree may hold, or 0 for no limit. When the limit is
+  // reached, the least visited subtrees are evicted to make room and the search
+  // carries on; see GameTree::Prune. Applies to each tree separately.
+  std::size_t max_tree_nodes_n = 0;
+
+  // If true, root noise is drawn once at the start of each move's search, as
+  // in AlphaZero, rather than at every visit to the root.
+  bool root_noise_per_move = false;
+
+  // If true, a move's search stops once the most visited root edge can't be
+  // overtaken by the simulations left, which saves search on lopsided moves.
+  bool early_stop = false;
+
+  // The fraction of the remaining simulations the runner-up is assumed able to
+  // win when deciding to stop early. 1 stops only when the leader is certain to
+  // stay ahead; lower values stop sooner, betting that the runner-up wouldn't
+  // be chosen for every remaining simulation.
+  float early_stop_margin = 1.0f;
+
+  // If true and full_play, the simulations saved by stopping early are added to
+  // the budget of the next move, up to doubling it.
+  bool early_stop_carry_over = false;
+
+  // Playout cap randomization: if full_play, each move is searched with
+  // simulations_n simulations with probability full_search_fraction, and only
+  // those moves are returned. The rest are searched with fast_simulations_n
+  // simulations and no root noise, and only decide the move to play. This
+  // yields more games per unit of search while keeping the recorded policy
+  // targets deep.
+  //
+  // KataGo uses 0.25, with a fast search of about a fifth of the full one.
+  float full_search_fraction = 1.0f;
+  int fast_simulations_n = 0;
+
+  // If not zero, the longest a search may run. When time runs out the search
+  // stops after the rounds in flight, reporting what the root has so far.
+  std::chrono::microseconds search_time_limit = 
+      std::chrono::microseconds::zero();
+
+  // If not zero, a search also stops once it has added about this many nodes
+  // to the tree (a few more may be added by rounds already in flight).
+  std::size_t max_search_nodes_n = 0;
+
+  // If true, exact outcomes are proven up the tree from terminal states (the
+  // MCTS-solver). Moves proven to lose stop being searched, proven subtrees
+  // are backed up without descending into them, and a search ends once the
+  // root is proven, with its search policy set to the proving move.
+  //
+  // Only terminal states can be proven in non-deterministic games, since a
+  // move's child there is just one of its possible results.
+  bool solve = false;
+
+  // If not zero and the game is hashable, up to about this many network
+  // evaluations are cached by game state, so states seen again (in later
+  // games, say, or after a tree is cleared) skip the forward pass until the
+  // network's weights change. Trees sharing a cache (see
+  // GameTree::set_evaluation_cache) share its size too.
+  std::size_t evaluation_cache_n = 0;
+
+  // If not zero, the root is searched with Gumbel sequential halving
+  // (Danihelka et al., "Policy improvement by planning with Gumbel") rather
+  // than PUCT with root noise. This many moves are sampled without replacement
+  // from the priors perturbed with Gumbel noise, and the simulations are split
+  // into rounds that each search the moves left evenly and then keep the
+  // better half of them. The move played is the best one left, and the search
+  // policy is the prior improved by the root's completed outcomes rather than
+  // the visit proportions, which gives a usable policy target from far fewer
+  // simulations. Below the root, PUCT is used as usual.
+  //
+  // Root noise, early stopping and the one-hot breakover don't apply. The
+  // paper uses 16.
+  int gumbel_considered_n = 0;
+
+  // The outcome q of a root move is scaled by
+  // (gumbel_visit_scale + the greatest root visit count) * gumbel_value_scale
+  // before being added to its prior's logit. The paper uses 50 and 1.
+  float gumbel_visit_scale = 50.0f;
+  float gumbel_value_scale = 1.0f;
+
+  // If not zero, whenever a search round adds a node to the tree, the states
+  // reached by its speculative_children_n highest prior moves are evaluated
+  // along with the leaves of the thread's next round, and parked until a
+  // descent expands them, which then needs no evaluation of its own. The
+  // extra states ride along in batches that run anyway, taking a network round
+  // trip off the descents most likely to come next, so speculating only
+  // happens when evaluations are batched: through an inference service (see
+  // GameTree::set_inference_service), across concurrent games, or when a
+  // round's leaves and speculations fill a batch of the network's batched
+  // counterpart. Parked states count towards max_tree_nodes_n, and those
+  // left unused for long are dropped. Unused in open-loop trees.
+  int speculative_children_n = 0;
+
+  // If true, positions with a single move aren't searched: self-play makes the
+  // move at once, and a session returns it without running any simulations.
+  // Inside the tree, a leaf that starts a chain of forced moves is expanded
+  // along with the whole chain, and only the state at its end is evaluated;
+  // the forced states take that state's predicted outcome. A chain that runs
+  // into a state already in the tree ends there instead. Room for the longest
+  // chain seen so far is kept free of max_tree_nodes_n.
+  bool skip_forced_moves = false;
+
+  // If not zero and full_play, a player resigns once the value of the position
+  // to them (the mean outcome their search found through the root's moves)
+  // has been below resign_threshold for resign_moves_n of their moves in a
+  // row. The game is adjudicated there rather than played out: the resigning
+  // player's outcome is 0, and the others share the rest in proportion to the
+  // outcomes predicted for them at the root.
+  //
+  // A resign_playout_fraction of the games that would be resigned are played
+  // out anyway, to measure how often resigning is a mistake; see
+  // CallbacksBase::ResignationPlayedOut. AlphaGo Zero plays out 10% of them and
+  // keeps the threshold where fewer than 5% would have been won.
+  float resign_threshold = 0.0f;
+  int resign_moves_n = 1;
+  float resign_playout_fraction = 0.0f;
+
+  // If set, full games play the positions found in the cache from their
+  // stored results rather than searching them; see BuildOpeningCache. The
+  // cached policy is recorded as the move's search policy (whether or not the
+  // move drew a fast search), and the move is sampled from it with fresh root
+  // noise interpolated in, so games still diverge where a search's noise
+  // would have steered them apart. Sessions don't use the cache. Not owned,
+  // and not to be added to while games are played.
+  //
+  // Only a cache tagged with opening_checkpoint, the checkpoint the networks'
+  // weights come from, is used; one searched with other weights is ignored.
+  const OpeningCache* opening_cache = nullptr;
+  uint64_t opening_checkpoint = 0;
+
+  // If true, search trees are open-loop: a node stands for the sequence of
+  // moves that reaches it rather than for a game state, and only the root
+  // holds its game. Each descent replays its moves from the root's game,
+  // drawing chance events afresh, so in a non-deterministic game the
+  // statistics of a move cover all of its outcomes rather than the one drawn
+  // when it was expanded. Nodes shrink to their statistics, at the cost of
+  // replaying the moves of every descent.
+  //
+  // A descent whose replayed state doesn't fit the node it reaches (a
+  // different player to move or number of moves, or only one of them over)
+  // stops there and backs up that state's own outcome. Transpositions aren't
+  // shared in open-loop trees.
+  bool open_loop = false;
+};
+
+// The number of networks (with the same weights) that SelfPlay needs to search
+// with the given config.
+inline int SearchNetworksN(const Config& config) {
+  return config.full_play
+      ? config.search_threads_n
+      : config.search_threads_n * config.root_trees_n;
+}
+
+// The number of leaves each search round with the given config and network
+// collects; see Config::leaf_batch_n.
+inline int LeafBatchN(const Config& config, games::GameNetwork* network) {
+  if (config.leaf_batch_n != 0) return config.leaf_batch_n;
+  games::GameNetwork* batched = network->Batched();
+  return (batched == nullptr) ? 1 : batched->batch_n();
+}
+
 namespace internal {
 
-template <games::AnyGameType Game>
-struct TreeEdge {
-  TreeEdge(float search_prob, std::size_t parent_i) :
-      search_prob(search_prob), parent_i(parent_i) {
-    std::fill(outcome.begin(), outcome.end(), 0.0f);
-    std::fill(acc_outcome.begin(), acc_outcome.end(), 0.0f);
-    visits_n = 0;
-    child_i = -1;
+// What the network has to say about a single game state.
+template <games::AnyGameType Game>
+struct Evaluation {
+  // The predicted outcome in (un-rotated) player order.
+  std::array<float, Game::players_n()> outcome;
+
+  // The normalized search probability of each move, in move order.
+  std::vector<float> policy;
+};
+
+// Fills noise with a sample of a symmetric Dirichlet distribution.
+static inline void DirichletNoise(std::vector<float>& noise, float alpha,
+                                  absl::BitGenRef bitgen) {
+  // 1D, so \beta = 1.
+  std::gamma_distribution<float> gamma(alpha);
+  float sum = 0.0f;
+  for (auto& x : noise) {
+    x = gamma(bitgen);
+    sum += x;
+  }
+  for (auto& x : noise) x /= sum;
+}
+
+// A game tree that can be grown by several search threads at once. Statistics
+// are updated atomically, and a barren edge is claimed by exactly one thread
+// before it's expanded.
+//
+// Nodes and edges are stored column-wise with 32-bit indices, and the edges of
+// a node occupy a contiguous range, so that choosing an edge scans a few
+// densely packed arrays. Edges keep only the outcome of the player making the
+// move; see outcome().
+//
+// If the game can be hashed, a state reached by different sequences of moves
+// is held by a single node, making the tree a DAG. Statistics live on edges, so
+// the value of each way into a shared node is still tracked separately;
+// outcomes are backed up along the path a descent took.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork>
+class GameTree {
+ public:
+  // The index of a node or edge.
+  using Index = uint32_t;
+
+  // Marks an edge with no child node at the other end. The edge is a candidate
+  // for expansion. Also used as the source edge of a root node.
+  static constexpr Index kBarren = -1;
+  // Marks an edge whose child node is being evaluated by some search thread.
+  static constexpr Index kPending = -2;
+
+  // Scratch space for one search thread.
+  class Worker {
+   private:
+    friend class GameTree<Game, GameNetwork>;
+
+    // Noise interpolated with the policy to encourage exploration, and the
+    // resulting root priors.
+    std::vector<float> noise;
+    std::vector<float> root_priors;
+
+    // The statistics of the edges being chosen between, copied out of the tree
+    // so that they can be scored together, and their scores. Only ever grown.
+    Eigen::ArrayXf edge_visits;
+    Eigen::ArrayXf edge_outcome_sums;
+    Eigen::ArrayXf edge_proven_outcomes;
+    Eigen::ArrayXf edge_values;
+    // The edges traversed by the current descent, from the root down.
+    std::vector<Index> path;
+    // The state reached by the current descent, if open-loop. Games needn't be
+    // assignable, so this is re-emplaced.
+    std::optional<Game> game;
+
+    // Parallel arrays of the leaves waiting on evaluation in this round, and
+    // the edges that lead to them (kBarren for an open-loop state that won't
+    // be added to the tree).
+    std::vector<Game> pending_games;
+    std::vector<Index> pending_edges_i;
+    std::vector<Evaluation<Game>> pending_evaluations;
+    // The paths to each pending leaf laid end to end; path i ends at
+    // pending_path_ends[i].
+    std::vector<Index> pending_paths;
+    std::vector<std::size_t> pending_path_ends;
+
+    // Child states to evaluate speculatively in the next round, the edges
+    // they're reached by, and the tree's layout_n_ when they were queued.
+    std::vector<Game> speculative_games;
+    std::vector<Index> speculative_edges_i;
+    uint64_t speculative_layout_n = 0;
+    // The edges of the speculative states being evaluated in this round,
+    // which follow the leaves in pending_games.
+    std::vector<Index> speculating_edges_i;
+    std::vector<int> speculative_moves_i;
+
+    // The forced states passed on the way to each pending leaf, laid end to
+    // end; those of leaf i end at pending_forced_ends[i]. See ExpandForced.
+    std::vector<Game> pending_forced_games;
+    std::vector<std::size_t> pending_forced_ends;
+    // The edges out of the forced states of a chain being added.
+    std::vector<Index> forced_edges_i;
+  };
+
+  // Evaluates game states for search threads; see set_inference_service.
+  using InferenceService = mcts::internal::InferenceService<
+      Game, Evaluation<Game>, GameNetwork>;
+
+  // Caches evaluations across trees; see set_evaluation_cache.
+  using EvaluationCache = mcts::internal::EvaluationCache<Evaluation<Game>>;
+
+  GameTree() :
+      arena_(std::make_unique<Arena>()),
+      spare_arena_(std::make_unique<Arena>()),
+      evaluation_cache_(&own_evaluation_cache_),
+      inference_service_(nullptr),
+      stop_(nullptr),
+      collapsed_n_(0),
+      longest_chain_n_(0),
+      early_stopped_n_(0),
+      layout_n_(0) {}
+
+  // Destroys every node and edge. Their memory is kept for the next tree.
+  // Cached evaluations are kept too.
+  void clear() {
+    arena_->clear();
+    transpositions_.clear();
+    ClearSpeculations();
+  }
+
+  // Caches up to about entries_n evaluations, or none if 0; see
+  // Config::evaluation_cache_n. Resizes the shared cache if there is one (see
+  // set_evaluation_cache). Has no effect unless the game is hashable.
+  //
+  // Not thread safe.
+  void set_evaluation_cache_n(std::size_t entries_n) {
+    if constexpr (games::HashableGameType<Game>) {
+      evaluation_cache_->set_size(entries_n);
+    }
+  }
+
+  // If not null, evaluations are cached in cache rather than in a cache of the
+  // tree's own, so that the trees searching with a network, and the copies
+  // sharing its version, share what it's evaluated. cache must outlive its
+  // use.
+  //
+  // Not thread safe.
+  void set_evaluation_cache(EvaluationCache* cache) {
+    evaluation_cache_ = (cache == nullptr) ? &own_evaluation_cache_ : cache;
+  }
+
+  // The cache evaluations are kept in, which is the tree's own unless
+  // set_evaluation_cache was given another.
+  EvaluationCache* evaluation_cache() const {
+    return evaluation_cache_;
+  }
+
+  // If not null, game states are evaluated by service rather than by the
+  // networks passed to searches, which then only stand for search threads and
+  // may all be the same network as the service's. Any number of trees may
+  // share a service; each search thread registers as one of its producers.
+  // service must outlive its use, and be built with EvaluateBatchWithNetwork.
+  //
+  // Not thread safe.
+  void set_inference_service(InferenceService* service) {
+    inference_service_ = service;
+  }
+
+  InferenceService* inference_service() const {
+    return inference_service_;
+  }
+
+  // If not null, searches stop after the rounds in flight whenever *stop is
+  // true, which lets another thread cut a search short. stop must outlive its
+  // use.
+  //
+  // Not thread safe.
+  void set_stop(const std::atomic<bool>* stop) {
+    stop_ = stop;
+  }
+
+  // Makes the node at root_i the root of the tree: every node that can't be
+  // reached from it is destroyed, and the rest are moved into breadth-first
+  // order so that the upper levels of the tree, which each descent passes
+  // through, sit close together. Returns the new index of the root.
+  //
+  // Invalidates every other node and edge index. Not thread safe.
+  Index Reroot(Index root_i) {
+    return Compact(root_i, 0);
+  }
+
+  // Shrinks the tree below root_i to at most nodes_n nodes (plus the root) by
+  // evicting the subtrees reached through the least visited edges. Evicted
+  // edges become barren again but keep their visit counts and outcomes, so
+  // the search still knows what they're worth and may expand them again.
+  // Returns the new index of the root, as with Reroot.
+  //
+  // Not thread safe.
+  Index Prune(Index root_i, std::size_t nodes_n) {
+    // Gather the most visits of any edge into each node, numbering nodes by
+    // their place in the queue. Transpositions give a node many parents, and
+    // Compact keeps it through any edge from a kept parent with enough visits,
+    // so it keeps no more nodes than have that many here.
+    compact_nodes_i_.assign(arena_->nodes.index_bound(), kBarren);
+    compact_queue_.clear();
+    compact_visits_.clear();
+    compact_nodes_i_[root_i] = 0;
+    compact_queue_.push_back(root_i);
+    for (std::size_t queue_i = 0; queue_i < compact_queue_.size(); ++queue_i) {
+      Index node_i = compact_queue_[queue_i];
+      for (int move_i = 0; move_i < moves_n(node_i); ++move_i) {
+        Index edge_i = this->edge_i(node_i, move_i);
+        Index child_i = this->child_i(edge_i);
+        if ((child_i == kBarren) || (child_i == root_i)) continue;
+        int visits_n = this->visits_n(edge_i);
+        Index child_queue_i = compact_nodes_i_[child_i];
+        if (child_queue_i == kBarren) {
+          compact_nodes_i_[child_i] = compact_queue_.size();
+          compact_queue_.push_back(child_i);
+          compact_visits_.push_back(visits_n);
+        } else {
+          int& max_visits_n = compact_visits_[child_queue_i - 1];
+          max_visits_n = std::max(max_visits_n, visits_n);
+        }
+      }
+    }
+    if (compact_visits_.size() <= nodes_n) return Reroot(root_i);
+
+    // Edges tied with the (nodes_n + 1)th most visited are evicted too.
+    std::nth_element(compact_visits_.begin(),
+                     compact_visits_.begin() + nodes_n,
+                     compact_visits_.end(), std::greater<int>());
+    return Compact(root_i, compact_visits_[nodes_n] + 1);
+  }
+
+  // Makes the node at root_i the root as with Reroot, evicting the subtrees
+  // of edges with fewer than min_visits_n visits.
+  Index Compact(Index root_i, int min_visits_n) {
+    NodeArray& from_nodes = arena_->nodes;
+    EdgeArray& from_edges = arena_->edges;
+    GameArray& from_games = arena_->games;
+    NodeArray& to_nodes = spare_arena_->nodes;
+    EdgeArray& to_edges = spare_arena_->edges;
+    GameArray& to_games = spare_arena_->games;
+    transpositions_.clear();
+    ClearSpeculations();
+
+    // Nodes are numbered as they're discovered, and have their edges
+    // allocated as they're dequeued.
+    compact_nodes_i_.assign(from_nodes.index_bound(), kBarren);
+    compact_queue_.clear();
+    compact_nodes_i_[root_i] = to_nodes.Allocate(1);
+    compact_queue_.push_back(root_i);
+    for (std::size_t queue_i = 0; queue_i < compact_queue_.size(); ++queue_i) {
+      Index from_node_i = compact_queue_[queue_i];
+      Index to_node_i = compact_nodes_i_[from_node_i];
+      Index moves_n = from_nodes.template get<kNodeMovesN>(from_node_i);
+      Index from_first_edge_i = 
+          from_nodes.template get<kNodeFirstEdgeI>(from_node_i);
+      Index to_first_edge_i = (moves_n == 0)
+          ? kBarren
+          : to_edges.Allocate(moves_n);
+      for (Index move_i = 0; move_i < moves_n; ++move_i) {
+        Index from_edge_i = from_first_edge_i + move_i;
+        Index to_edge_i = to_first_edge_i + move_i;
+        Index child_i = from_edges.template get<kEdgeChildI>(from_edge_i)
+            .load(std::memory_order_relaxed);
+        if (child_i == kPending) {
+          LOG(FATAL) << "Cannot re-root a tree mid-search.";
+        }
+        int visits_n = from_edges.template get<kEdgeVisitsN>(from_edge_i)
+            .load(std::memory_order_relaxed);
+        if (visits_n < min_visits_n) child_i = kBarren;
+        if (child_i != kBarren) {
+          if (compact_nodes_i_[child_i] == kBarren) {
+            compact_nodes_i_[child_i] = to_nodes.Allocate(1);
+            compact_queue_.push_back(child_i);
+          }
+          child_i = compact_nodes_i_[child_i];
+        }
+        to_edges.template Emplace<kEdgePrior>(
+            to_edge_i, from_edges.template get<kEdgePrior>(from_edge_i));
+        to_edges.template Emplace<kEdgeVisitsN>(to_edge_i, visits_n);
+        to_edges.template Emplace<kEdgeOutcomeSum>(
+            to_edge_i, from_edges.template get<kEdgeOutcomeSum>(from_edge_i)
+                .load(std::memory_order_relaxed));
+        to_edges.template Emplace<kEdgeChildI>(to_edge_i, child_i);
+        to_edges.template Emplace<kEdgeParentI>(to_edge_i, to_node_i);
+        // An evicted child can't back up its proven outcome, so the edge goes
+        // back to being searched.
+        to_edges.template Emplace<kEdgeProvenOutcome>(
+            to_edge_i, (child_i == kBarren)
+                ? kUnprovenOutcome
+                : from_edges.template get<kEdgeProvenOutcome>(from_edge_i)
+                    .load(std::memory_order_relaxed));
+      }
+
+      Index game_i = from_nodes.template get<kNodeGameI>(from_node_i);
+      if (game_i != kBarren) {
+        Index to_game_i = to_games.Allocate(1);
+        const Game& game = to_games.template Emplace<0>(
+            to_game_i, std::move(from_games.template get<0>(game_i)));
+        if constexpr (games::HashableGameType<Game>) {
+          transpositions_.Set(game.Hash(), to_node_i);
+        }
+        game_i = to_game_i;
+      }
+      to_nodes.template Emplace<kNodeGameI>(to_node_i, game_i);
+      to_nodes.template Emplace<kNodeFirstEdgeI>(to_node_i, to_first_edge_i);
+      to_nodes.template Emplace<kNodeMovesN>(to_node_i, moves_n);
+      to_nodes.template Emplace<kNodePlayerI>(
+          to_node_i, from_nodes.template get<kNodePlayerI>(from_node_i));
+      to_nodes.template Emplace<kNodeVisitSum>(
+          to_node_i, from_nodes.template get<kNodeVisitSum>(from_node_i)
+              .load(std::memory_order_relaxed));
+      to_nodes.template Emplace<kNodePredictedOutcome>(
+          to_node_i,
+          from_nodes.template get<kNodePredictedOutcome>(from_node_i));
+      to_nodes.template Emplace<kNodeProof>(
+          to_node_i, from_nodes.template get<kNodeProof>(from_node_i)
+              .load(std::memory_order_relaxed));
+      to_nodes.template Emplace<kNodeProvenOutcome>(
+          to_node_i, from_nodes.template get<kNodeProvenOutcome>(from_node_i));
+    }
+
+    arena_->clear();
+    std::swap(arena_, spare_arena_);
+    return compact_nodes_i_[root_i];
+  }
+
+  // The number of nodes and edges held.
+  std::size_t nodes_n() const {
+    return arena_->nodes.size();
+  }
+
+  std::size_t edges_n() const {
+    return arena_->edges.size();
+  }
+
+  // The game state at a node. In an open-loop tree, only the root has one.
+  const Game& game(Index node_i) const {
+    return arena_->games.template get<0>(node<kNodeGameI>(node_i));
+  }
+
+  // Gives a node the game state at it, as when an open-loop tree is rerooted.
+  //
+  // Not thread safe.
+  void SetGame(Index node_i, Game&& game) {
+    Index game_i = CheckIndex(arena_->games.Allocate(1), 1);
+    arena_->games.template Emplace<0>(game_i, std::move(game));
+    node<kNodeGameI>(node_i) = game_i;
+  }
+
+  // Whether game could be the state at a node: both are over, or neither is and
+  // they have the same player to move and number of moves. Always true in a
+  // closed-loop tree for the node's own state.
+  bool Matches(Index node_i, const Game& game) const {
+    if (game.State() == games::GameState::kOver) return terminal(node_i);
+    return !terminal(node_i) && (game.CurrentMovesN() == moves_n(node_i))
+        && (game.CurrentPlayerI() == node<kNodePlayerI>(node_i));
+  }
+
+  // The number of moves (and so edges) out of a node. 0 for terminal states.
+  int moves_n(Index node_i) const {
+    return node<kNodeMovesN>(node_i);
+  }
+
+  bool terminal(Index node_i) const {
+    return moves_n(node_i) == 0;
+  }
+
+  // The edge for the move at move_i, following the same order as the moves in
+  // Game::MakeMove.
+  Index edge_i(Index node_i, int move_i) const {
+    return node<kNodeFirstEdgeI>(node_i) + move_i;
+  }
+
+  // The number of forced states searches of this tree have expanded without
+  // evaluating them; see Config::skip_forced_moves. Only ever grows.
+  std::size_t collapsed_n() const {
+    return collapsed_n_.load(std::memory_order_relaxed);
+  }
+
+  // The number of simulations the last search of this tree didn't run because
+  // config.early_stop found the root's leader secure. Simulations cut short by
+  // any other limit don't count.
+  int early_stopped_n() const {
+    return early_stopped_n_;
+  }
+
+  // The sum of the visit counts of a node's edges.
+  int visit_sum(Index node_i) const {
+    return node<kNodeVisitSum>(node_i).load(std::memory_order_relaxed);
+  }
+
+  // The outcome predicted at a node, by the network or by the end of the game.
+  const std::array<float, Game::players_n()>& predicted_outcome(
+      Index node_i) const {
+    return node<kNodePredictedOutcome>(node_i);
+  }
+
+  // Whether the outcome of a node is known exactly: it's terminal, or (if
+  // config.solve) the outcomes of its children settle it.
+  bool proven(Index node_i) const {
+    return node<kNodeProof>(node_i).load(std::memory_order_acquire) == kProven;
+  }
+
+  // The exact outcome of a proven node.
+  const std::array<float, Game::players_n()>& proven_outcome(
+      Index node_i) const {
+    return node<kNodeProvenOutcome>(node_i);
+  }
+
+  // The move that achieves a proven node's outcome, preferring the most visited
+  // if there are several. -1 if the node isn't proven or is terminal.
+  int ProvenMoveI(Index node_i) const {
+    if (!proven(node_i)) return -1;
+    float outcome = proven_outcome(node_i)[node<kNodePlayerI>(node_i)];
+    int proven_move_i = -1;
+    for (int move_i = 0; move_i < moves_n(node_i); ++move_i) {
+      Index edge_i = this->edge_i(node_i, move_i);
+      if ((edge<kEdgeProvenOutcome>(edge_i).load(std::memory_order_relaxed)
+              == outcome)
+          && ((proven_move_i == -1)
+              || (visits_n(edge_i)
+                  > visits_n(this->edge_i(node_i, proven_move_i))))) {
+        proven_move_i = move_i;
+      }
+    }
+    return proven_move_i;
+  }
+
+  // The predicted search probability along an edge.
+  float prior(Index edge_i) const {
+    return edge<kEdgePrior>(edge_i);
+  }
+
+  // The number of times an edge has been traversed.
+  //
+  // While a descent through this edge is waiting on its leaf evaluation, the
+  // edge counts an extra visit that hasn't contributed to its outcome yet.
+  // This "virtual loss" depresses the edge's value so that other descents
+  // prefer different lines.
+  int visits_n(Index edge_i) const {
+    return edge<kEdgeVisitsN>(edge_i).load(std::memory_order_relaxed);
+  }
+
+  // The mean outcome found through an edge for the player making its move, or
+  // 0 if the edge hasn't been visited.
+  float outcome(Index edge_i) const {
+    int visits_n = this->visits_n(edge_i);
+    return (visits_n == 0)
+        ? 0.0f
+        : edge<kEdgeOutcomeSum>(edge_i).load(std::memory_order_relaxed)
+            / static_cast<float>(visits_n);
+  }
+
+  // The index of an edge's child node, or one of kBarren / kPending.
+  //
+  // A child node and its edges are fully built before their index is stored,
+  // so an index returned here can be read freely.
+  Index child_i(Index edge_i) const {
+    return edge<kEdgeChildI>(edge_i).load(std::memory_order_acquire);
+  }
+
+  // Grows the tree below root_i by simulations_n simulations, split between
+  // one search thread per network. All of the networks should hold the same
+  // weights.
+  //
+  // Fewer simulations are run if config.early_stop allows, once
+  // config.search_time_limit or config.max_search_nodes_n is reached, or if
+  // the search is stopped (see set_stop); the number run is the growth of the
+  // root's visit sum.
+  //
+  // If config.max_tree_nodes_n is set, searching pauses whenever the tree is
+  // about to outgrow it so that the tree can be pruned down to half of the
+  // budget. Returns the index of the root, which changes if the tree was
+  // pruned.
+  //
+  // The calling thread searches with the first network and bitgen.
+  Index Search(Index root_i, const std::vector<GameNetwork*>& networks,
+               const Config& config, int simulations_n,
+               absl::BitGenRef bitgen) {
+    if (config.leaf_batch_n == 0) {
+      Config batch_config = config;
+      batch_config.leaf_batch_n = LeafBatchN(config, networks[0]);
+      return Search(root_i, networks, batch_config, simulations_n, bitgen);
+    }
+    early_stopped_n_ = 0;
+    Limits limits = NewLimits(config, networks.size());
+    if (config.gumbel_considered_n > 0) {
+      return SearchGumbel(root_i, networks, config, simulations_n, limits,
+                          bitgen);
+    }
+    if (config.root_noise_per_move && (config.root_noise_lerp != 0.0f)) {
+      DrawRootNoise(root_i, config, bitgen);
+    }
+    SearchPruning(root_i, networks, config, simulations_n, {}, limits, bitgen);
+    return root_i;
+  }
+
+  // The move chosen by the last search from root_i, which must have been a
+  // Gumbel search (see Config::gumbel_considered_n): of the moves sequential
+  // halving left, the one with the greatest Gumbel score.
+  int GumbelMoveI(Index root_i, const Config& config) const {
+    std::vector<float> outcomes;
+    CompletedOutcomes(root_i, outcomes);
+    int max_visits_n = MaxVisitsN(root_i);
+    int best_move_i = gumbel_moves_i_[0];
+    float best_score = -std::numeric_limits<float>::infinity();
+    for (int move_i : gumbel_moves_i_) {
+      float score = gumbel_scores_[move_i] 
+          + GumbelTransform(outcomes[move_i], max_visits_n, config);
+      if (score > best_score) {
+        best_score = score;
+        best_move_i = move_i;
+      }
+    }
+    return best_move_i;
+  }
+
+  // Writes the improved policy of the root at root_i to policy, in move order:
+  // the softmax of the prior logits plus the transformed completed outcome of
+  // each move. Moves that weren't searched are given the root's mixed value
+  // estimate as their outcome.
+  void GumbelPolicy(Index root_i, const Config& config, float* policy) const {
+    std::vector<float> outcomes;
+    CompletedOutcomes(root_i, outcomes);
+    int max_visits_n = MaxVisitsN(root_i);
+    float max_logit = -std::numeric_limits<float>::infinity();
+    for (int move_i = 0; move_i < moves_n(root_i); ++move_i) {
+      policy[move_i] = PriorLogit(edge_i(root_i, move_i)) 
+          + GumbelTransform(outcomes[move_i], max_visits_n, config);
+      max_logit = std::max(max_logit, policy[move_i]);
+    }
+    float sum = 0.0f;
+    for (int move_i = 0; move_i < moves_n(root_i); ++move_i) {
+      policy[move_i] = std::expf(policy[move_i] - max_logit);
+      sum += policy[move_i];
+    }
+    for (int move_i = 0; move_i < moves_n(root_i); ++move_i) {
+      policy[move_i] /= sum;
+    }
+  }
+
+  // Draws the noise mixed into the priors of the root's edges for every
+  // descent until the next draw. Only used if config.root_noise_per_move.
+  void DrawRootNoise(Index root_i, const Config& config,
+                     absl::BitGenRef bitgen) {
+    MixRootNoise(root_i, config, bitgen, root_noise_, root_priors_);
+  }
+
+  // Runs one search round from the root at root_i: up to leaf_batch_n descents
+  // are made, the leaves they reach are evaluated together, and then all of
+  // them are backed up. With config.root_noise_per_move, DrawRootNoise must be
+  // called first.
+  //
+  // If root_moves isn't empty, it holds leaf_batch_n moves, and each descent
+  // takes the next of them at the root instead of choosing one.
+  //
+  // A round ends early if a descent runs into a leaf that's already waiting on
+  // evaluation. Returns the number of simulations completed. Thread safe
+  // provided every thread has its own worker.
+  int Search(Index root_i, GameNetwork* network, const Config& config,
+             int leaf_batch_n, absl::BitGenRef bitgen, Worker& worker,
+             std::span<const int> root_moves = {}) {
+    int simulations_n = StartRound(root_i, config, leaf_batch_n, bitgen, worker,
+                                   root_moves);
+    if (worker.pending_games.empty()) return simulations_n;
+    EvaluateBatch(worker.pending_games, network, worker.pending_evaluations);
+    FinishRound(config, SpeculationBatches(config, network), bitgen, worker);
+    return simulations_n;
+  }
+
+  int Search(Index root_i, GameNetwork* network, const Config& config,
+             int leaf_batch_n, absl::BitGenRef bitgen) {
+    return Search(root_i, network, config, leaf_batch_n, bitgen, worker_);
+  }
+
+  // The game states a suspended search needs evaluated before it can carry
+  // on, with EvaluateBatch of tree, into evaluations.
+  struct EvaluationRequest {
+    GameTree* tree;
+    const std::vector<Game>* games;
+    std::vector<Evaluation<Game>>* evaluations;
+  };
+  using SearchTask = mcts::internal::Task<EvaluationRequest>;
+
+  // Searches like Search on the calling thread alone, but as a task that
+  // suspends with a request for the leaves of each round rather than
+  // evaluating them itself. Whoever runs the task evaluates them, with a
+  // network holding the search's weights, and resumes it; see
+  // SelfPlayConcurrently. root_i is updated if the tree is pruned.
+  //
+  // Gumbel searches aren't supported, nor is config.search_time_limit, since
+  // the thread's time is shared with whatever else it runs. There's no network
+  // to resolve a config.leaf_batch_n of 0 with, so it must be set.
+  SearchTask SearchSuspending(Index& root_i, const Config& config,
+                              int simulations_n, absl::BitGenRef bitgen) {
+    if (config.leaf_batch_n < 1) {
+      LOG(FATAL) << "Suspending searches need a leaf_batch_n of at least 1.";
+    }
+    if ((config.gumbel_considered_n > 0)
+        || (config.search_time_limit != std::chrono::microseconds::zero())) {
+      LOG(FATAL) << "Suspending searches support neither Gumbel search nor "
+                    "time limits.";
+    }
+    early_stopped_n_ = 0;
+    Limits limits = NewLimits(config, 1);
+    if (config.root_noise_per_move && (config.root_noise_lerp != 0.0f)) {
+      DrawRootNoise(root_i, config, bitgen);
+    }
+    int run_n = 0;
+    while ((run_n < simulations_n) && (limits.expansions_left_n > 0)) {
+      if (config.solve && proven(root_i)) break;
+      if (config.early_stop 
+          && LeaderSecure(root_i, config.early_stop_margin, 
+                          simulations_n - run_n)) {
+        early_stopped_n_ = simulations_n - run_n;
+        break;
+      }
+      if (nodes_n() >= limits.nodes_limit) {
+        root_i = Prune(root_i, config.max_tree_nodes_n / 2 - 1);
+        if (nodes_n() >= limits.nodes_limit) break;
+      }
+      std::size_t start_nodes_n = nodes_n();
+      run_n += StartRound(root_i, config,
+                          std::min(config.leaf_batch_n, simulations_n - run_n),
+                          bitgen, worker_);
+      if (!worker_.pending_games.empty()) {
+        co_await EvaluationRequest{this, &worker_.pending_games,
+                                   &worker_.pending_evaluations};
+        // Whoever runs the task evaluates the requests of many searches
+        // together.
+        FinishRound(config, SpeculationsLimit(config) != 0, bitgen, worker_);
+      }
+      limits.expansions_left_n -= std::min(nodes_n() - start_nodes_n,
+                                           limits.expansions_left_n);
+    }
+  }
+
+  // Evaluates a game state and adds it to the tree at the end of
+  // source_edge_i (kBarren for a root). Returns the new node's index.
+  Index ExpandNode(Game&& expanded_game, Index source_edge_i,
+                   GameNetwork* network) {
+    if (expanded_game.State() == games::GameState::kOver) {
+      return AddNode(std::move(expanded_game), source_edge_i, nullptr, true);
+    }
+    Evaluation<Game> evaluation;
+    Evaluate(expanded_game, network, evaluation);
+    return AddNode(std::move(expanded_game), source_edge_i, &evaluation, true);
+  }
+
+  // As above, with the game state already evaluated. evaluation may be null
+  // if the state is terminal.
+  Index ExpandNode(Game&& expanded_game, Index source_edge_i,
+                   const Evaluation<Game>* evaluation) {
+    bool over = expanded_game.State() == games::GameState::kOver;
+    return AddNode(std::move(expanded_game), source_edge_i,
+                   over ? nullptr : evaluation, true);
+  }
+
+  // Evaluates a batch of ongoing game states, using the evaluation cache if
+  // there is one, and the inference service if there is one. The states
+  // missing from the cache are all queued with the service before waiting on
+  // any of them, so they can share its batches; without a service, they're
+  // evaluated together as by EvaluateRequests.
+  void EvaluateBatch(const std::vector<Game>& games, GameNetwork* network,
+                     std::vector<Evaluation<Game>>& evaluations) {
+    evaluations.resize(games.size());
+    if (inference_service_ == nullptr) {
+      const EvaluationRequest request{this, &games, &evaluations};
+      const EvaluationRequest* requests[] = {&request};
+      EvaluateRequests(requests, network);
+      return;
+    }
+    std::vector<std::future<Evaluation<Game>>> futures(games.size());
+    for (std::size_t i = 0; i < games.size(); ++i) {
+      if (FindCached(games[i], network, evaluations[i])) continue;
+      futures[i] = inference_service_->Evaluate(Game(games[i]));
+    }
+    for (std::size_t i = 0; i < games.size(); ++i) {
+      if (!futures[i].valid()) continue;
+      evaluations[i] = inference_service_->Wait(futures[i]);
+      AddCached(games[i], network, evaluations[i]);
+    }
+  }
+
+  // Evaluates the states of every request that isn't null with network, using
+  // the evaluation cache of each request's tree. The states missing from the
+  // caches are evaluated together by EvaluateBatchWithNetwork, so requests
+  // from many trees share forward passes.
+  static void EvaluateRequests(
+      std::span<const EvaluationRequest* const> requests,
+      GameNetwork* network) {
+    std::vector<const Game*> missing_games;
+    std::vector<Evaluation<Game>*> missing_evaluations;
+    std::vector<GameTree*> missing_trees;
+    for (const EvaluationRequest* request : requests) {
+      if (request == nullptr) continue;
+      const std::vector<Game>& games = *(request->games);
+      std::vector<Evaluation<Game>>& evaluations = *(request->evaluations);
+      evaluations.resize(games.size());
+      for (std::size_t i = 0; i < games.size(); ++i) {
+        if (request->tree->FindCached(games[i], network, evaluations[i])) {
+          continue;
+        }
+        missing_games.push_back(&games[i]);
+        missing_evaluations.push_back(&evaluations[i]);
+        missing_trees.push_back(request->tree);
+      }
+    }
+    EvaluateBatchWithNetwork(network, missing_games, missing_evaluations);
+    for (std::size_t i = 0; i < missing_games.size(); ++i) {
+      missing_trees[i]->AddCached(*missing_games[i], network,
+                                  *missing_evaluations[i]);
+    }
+  }
+
+  void Evaluate(const Game& game, GameNetwork* network,
+                Evaluation<Game>& evaluation) {
+    if (FindCached(game, network, evaluation)) return;
+    if (inference_service_ != nullptr) {
+      // Roots are expanded outside of the search threads, so this registers
+      // a producer of its own.
+      typename InferenceService::Producer producer(inference_service_);
+      auto future = inference_service_->Evaluate(Game(game));
+      evaluation = inference_service_->Wait(future);
+    } else {
+      EvaluateWithNetwork(game, network, evaluation);
+    }
+    AddCached(game, network, evaluation);
+  }
+
+  // Evaluates *games[i] into *evaluations[i] for every i with network, in as
+  // few forward passes as its batched counterpart (see
+  // games::GameNetwork::Batched) allows. States left over once less than a
+  // full batch remains are evaluated one at a time: a batched pass costs about
+  // as much as batch_n single ones less a few percent, so padding it never
+  // pays.
+  static void EvaluateBatchWithNetwork(
+      GameNetwork* network, std::span<const Game* const> games,
+      std::span<Evaluation<Game>* const> evaluations) {
+    std::size_t i = 0;
+    games::GameNetwork* batched = (games.size() > 1)
+        ? network->Batched()
+        : nullptr;
+    if (batched != nullptr) {
+      std::size_t batch_n = batched->batch_n();
+      for (; games.size() - i >= batch_n; i += batch_n) {
+        EvaluateWithNetwork(games.subspan(i, batch_n), batched,
+                            evaluations.subspan(i, batch_n));
+      }
+    }
+    for (; i < games.size(); ++i) {
+      EvaluateWithNetwork(games.subspan(i, 1), network,
+                          evaluations.subspan(i, 1));
+    }
+  }
+
+  // As above, for states and evaluations laid out in order.
+  static void EvaluateBatchWithNetwork(
+      GameNetwork* network, std::span<const Game> games,
+      std::span<Evaluation<Game>> evaluations) {
+    std::vector<const Game*> games_p;
+    std::vector<Evaluation<Game>*> evaluations_p;
+    for (std::size_t i = 0; i < games.size(); ++i) {
+      games_p.push_back(&games[i]);
+      evaluations_p.push_back(&evaluations[i]);
+    }
+    EvaluateBatchWithNetwork(network, games_p, evaluations_p);
+  }
+
+  static void EvaluateWithNetwork(const Game& game, GameNetwork* network,
+                                  Evaluation<Game>& evaluation) {
+    const Game* games[] = {&game};
+    Evaluation<Game>* evaluations[] = {&evaluation};
+    EvaluateWithNetwork(games, network, evaluations);
+  }
+
+ private:
+  // Evaluates network->batch_n() states in one forward pass, state b taking
+  // block b of the network's inputs and column b of its outputs.
+  static void EvaluateWithNetwork(
+      std::span<const Game* const> games, games::GameNetwork* network,
+      std::span<Evaluation<Game>* const> evaluations) {
+    std::size_t batch_n = network->batch_n();
+    std::vector<nn::DynamicMatrix> inputs;
+    for (std::size_t b = 0; b < games.size(); ++b) {
+      std::vector<nn::DynamicMatrix> state = games[b]->StateToMatrix();
+      if (batch_n == 1) {
+        inputs = std::move(state);
+        break;
+      }
+      if (inputs.empty()) {
+        for (const auto& input : state) {
+          inputs.emplace_back(input.rows(), input.cols() * batch_n);
+        }
+      }
+      for (std::size_t j = 0; j < state.size(); ++j) {
+        std::size_t cols_n = state[j].cols();
+        inputs[j].middleCols(b * cols_n, cols_n) = state[j];
+      }
+    }
+    network->SetConstants(network->input_constant_indices(), inputs);
+
+    // The outcome, then the policy head of each class in the batch.
+    std::vector<uint32_t> outputs_i = {network->outcome_output_index()};
+    std::vector<std::size_t> policy_outputs_i(games.size());
+    for (std::size_t b = 0; b < games.size(); ++b) {
+      uint32_t output_i = 
+          network->policy_output_indices()[games[b]->PolicyClassI()];
+      auto iter = std::find(outputs_i.begin() + 1, outputs_i.end(), output_i);
+      policy_outputs_i[b] = iter - outputs_i.begin();
+      if (iter == outputs_i.end()) outputs_i.push_back(output_i);
+    }
+    std::vector<nn::DynamicMatrix> model_outputs;
+    network->Outputs(outputs_i, model_outputs);
+
+    nn::DynamicMatrix policy;
+    for (std::size_t b = 0; b < games.size(); ++b) {
+      const Game& game = *games[b];
+      Evaluation<Game>& evaluation = *evaluations[b];
+
+      // We normalize the search probabilities because we don't expect the
+      // model to.
+      policy = model_outputs[policy_outputs_i[b]].col(b);
+      evaluation.policy.resize(game.CurrentMovesN());
+      float policy_sum = 0.0f;
+      for (int i = 0; i < game.CurrentMovesN(); ++i) {
+        evaluation.policy[i] = game.PolicyForMoveI(policy, i);
+        policy_sum += evaluation.policy[i];
+      }
+      for (auto& p : evaluation.policy) p /= policy_sum;
+
+      // Since the model is trying to predict an outcome vector rotated s.t.
+      // the current player is in the first row, un-rotate the prediction.
+      for (int i = 0; i < Game::players_n(); ++i) {
+        evaluation.outcome[(i + game.CurrentPlayerI()) % Game::players_n()] =
+            model_outputs[0](i, b);
+      }
+    }
+  }
+
+  // Node columns.
+  //
+  // The index of the node's game in the arena's games, or kBarren if it
+  // doesn't keep one.
+  static constexpr std::size_t kNodeGameI = 0;
+  static constexpr std::size_t kNodeFirstEdgeI = 1;
+  static constexpr std::size_t kNodeMovesN = 2;
+  // The player making the move at the node, 0 at terminal states.
+  static constexpr std::size_t kNodePlayerI = 3;
+  static constexpr std::size_t kNodeVisitSum = 4;
+  static constexpr std::size_t kNodePredictedOutcome = 5;
+  // One of the Proof values.
+  static constexpr std::size_t kNodeProof = 6;
+  // The exact outcome of the node, once kNodeProof is kProven.
+  static constexpr std::size_t kNodeProvenOutcome = 7;
+  using NodeArray = mcts::internal::ChunkedArray<
+      Index, Index, uint16_t, uint8_t, std::atomic<int>,
+      std::array<float, Game::players_n()>, std::atomic<uint8_t>,
+      std::array<float, Game::players_n()>>;
+
+  enum Proof : uint8_t {
+    kUnproven = 0,
+    // Some thread is writing the proven outcome.
+    kProving = 1,
+    kProven = 2
+  };
+
+  // Edge columns.
+  static constexpr std::size_t kEdgePrior = 0;
+  static constexpr std::size_t kEdgeVisitsN = 1;
+  // The sum of the outcomes found through the edge, for the player at the
+  // parent node.
+  static constexpr std::size_t kEdgeOutcomeSum = 2;
+  static constexpr std::size_t kEdgeChildI = 3;
+  // The parent node. With transpositions, the child node may have other
+  // parents too.
+  static constexpr std::size_t kEdgeParentI = 4;
+  // The proven outcome of the child node for the player at the parent node, or
+  // kUnprovenOutcome. Only set by the solver.
+  static constexpr std::size_t kEdgeProvenOutcome = 5;
+  using EdgeArray = mcts::internal::ChunkedArray<
+      float, std::atomic<int>, std::atomic<float>, std::atomic<Index>,
+      Index, std::atomic<float>>;
+
+  static constexpr float kUnprovenOutcome = -1.0f;
+
+  using GameArray = mcts::internal::ChunkedArray<Game>;
+
+  // Nodes, edges and games are allocated from an arena that's cleared and
+  // refilled rather than freed, so memory is reused as the root advances and
+  // from one game to the next.
+  struct Arena {
+    NodeArray nodes;
+    EdgeArray edges;
+    GameArray games;
+
+    void clear() {
+      nodes.clear();
+      edges.clear();
+      games.clear();
+    }
+  };
+  // The arena holding the tree.
+  std::unique_ptr<Arena> arena_;
+  // The arena the tree is compacted into by Reroot, empty otherwise.
+  std::unique_ptr<Arena> spare_arena_;
+
+  // Scratch space for Prune and Compact: the new index of each node by its old
+  // index, the old indices of nodes in breadth-first order, and the most
+  // visits of any edge into each.
+  std::vector<Index> compact_nodes_i_;
+  std::vector<Index> compact_queue_;
+  std::vector<int> compact_visits_;
+
+  // The worker used by single-threaded searches.
+  Worker worker_;
+
+  // Runs the share of a search of one of the threads past the first.
+  class HelperSearchFn : public mcts::internal::WorkQueueElement {
+   public:
+    explicit HelperSearchFn(std::function<void()>&& search_fn) :
+        search_fn_(std::move(search_fn)) {}
+
+    void run() override {
+      search_fn_();
+    }
+
+   private:
+    std::function<void()> search_fn_;
+  };
+
+  // The workers and random streams of the threads past the first of
+  // multi-threaded searches, and the queue whose threads run them. Kept
+  // between searches and grown as needed; see Config::search_threads_n.
+  std::deque<Worker> helper_workers_;
+  std::deque<absl::BitGen> helper_bitgens_;
+  std::unique_ptr<mcts::internal::WorkQueue> helper_queue_;
+
+  // The root noise drawn by DrawRootNoise, and the root priors mixed with it.
+  std::vector<float> root_noise_;
+  std::vector<float> root_priors_;
+
+  // The Gumbel noise plus prior logit of each root move drawn by the last
+  // Gumbel search, and the moves still being considered.
+  std::vector<float> gumbel_scores_;
+  std::vector<int> gumbel_moves_i_;
+  // The root moves of the current round of sequential halving.
+  std::vector<int> gumbel_schedule_;
+
+  // Only used if the game is hashable.
+  mcts::internal::TranspositionTable transpositions_;
+  EvaluationCache own_evaluation_cache_;
+  // Either own_evaluation_cache_ or a shared cache.
+  EvaluationCache* evaluation_cache_;
+
+  InferenceService* inference_service_;
+  const std::atomic<bool>* stop_;
+
+  std::atomic<std::size_t> collapsed_n_;
+  // The most forced states a single chain has added. Only ever grows.
+  std::atomic<std::size_t> longest_chain_n_;
+  int early_stopped_n_;
+
+  // A speculatively evaluated child state, parked until its edge is expanded.
+  struct Speculation {
+    Game game;
+    Evaluation<Game> evaluation;
+  };
+  // Parked speculations by edge index. Edge indices only hold until the tree
+  // is next cleared or compacted, which drops them all and counts a new
+  // layout.
+  std::mutex speculations_m_;
+  // GUARDED_BY(speculations_m_)
+  absl::flat_hash_map<Index, Speculation> speculations_;
+  // The edges of speculations_ in the order they were parked, including
+  // any taken since. GUARDED_BY(speculations_m_)
+  std::deque<Index> speculations_order_;
+  uint64_t layout_n_;
+
+  // The rounds of speculations each search thread may have parked at once.
+  // Speculations still unused that many rounds later are dropped.
+  static constexpr std::size_t kSpeculationRoundsN = 16;
+
+  // The most speculations a tree parks at once. They take a game each, like
+  // nodes, so they're held within Config::max_tree_nodes_n; see NewLimits.
+  static std::size_t SpeculationsLimit(const Config& config) {
+    if ((config.speculative_children_n <= 0) || config.open_loop) return 0;
+    return kSpeculationRoundsN * config.search_threads_n * config.leaf_batch_n
+        * config.speculative_children_n;
+  }
+
+  // Whether the speculative states of rounds searched with network ride along
+  // in batched forward passes: through an inference service, or with the
+  // network's batched counterpart when a round's leaves and speculations can
+  // fill one of its batches. Otherwise each costs a pass of its own, which
+  // makes speculating slower than not.
+  bool SpeculationBatches(const Config& config, GameNetwork* network) {
+    if ((config.speculative_children_n <= 0) || config.open_loop) return false;
+    if (inference_service_ != nullptr) return true;
+    games::GameNetwork* batched = network->Batched();
+    return (batched != nullptr)
+        && (config.leaf_batch_n * (1 + config.speculative_children_n)
+            >= batched->batch_n());
   }
 
-  // The sum of all outcomes predicted or discovered through this edge.
-  std::array<float, Game::players_n()> acc_outcome;
+  // Not thread safe.
+  void ClearSpeculations() {
+    speculations_.clear();
+    speculations_order_.clear();
+    ++layout_n_;
+  }
 
-  // outcome = acc_outcome / visits_n.
-  std::array<float, Game::players_n()> outcome;
+  // Parks a speculation, dropping the oldest beyond limit.
+  void ParkSpeculation(Index edge_i, Game&& game,
+                       Evaluation<Game>&& evaluation, std::size_t limit) {
+    std::lock_guard<std::mutex> lock(speculations_m_);
+    auto [iter, is_new] = speculations_.try_emplace(
+        edge_i, Speculation{std::move(game), std::move(evaluation)});
+    if (!is_new) return;
+    speculations_order_.push_back(edge_i);
+    while (speculations_order_.size() > limit) {
+      speculations_.erase(speculations_order_.front());
+      speculations_order_.pop_front();
+    }
+  }
+
+  std::optional<Speculation> TakeSpeculation(Index edge_i) {
+    std::lock_guard<std::mutex> lock(speculations_m_);
+    auto iter = speculations_.find(edge_i);
+    if (iter == speculations_.end()) return std::nullopt;
+    std::optional<Speculation> speculation(std::move(iter->second));
+    speculations_.erase(iter);
+    return speculation;
+  }
+
+  // Copies the cached evaluation of game by network into evaluation, if
+  // there's one.
+  bool FindCached(const Game& game, GameNetwork* network,
+                  Evaluation<Game>& evaluation) {
+    if constexpr (games::HashableGameType<Game>) {
+      return evaluation_cache_->enabled()
+          && evaluation_cache_->Find(game.Hash(), network->version(),
+                                     evaluation);
+    }
+    return false;
+  }
+
+  void AddCached(const Game& game, GameNetwork* network,
+                 const Evaluation<Game>& evaluation) {
+    if constexpr (games::HashableGameType<Game>) {
+      if (evaluation_cache_->enabled()) {
+        evaluation_cache_->Add(game.Hash(), network->version(), evaluation);
+      }
+    }
+  }
+
+  template <std::size_t ColumnI>
+  auto& node(Index node_i) {
+    return arena_->nodes.template get<ColumnI>(node_i);
+  }
+
+  template <std::size_t ColumnI>
+  const auto& node(Index node_i) const {
+    return arena_->nodes.template get<ColumnI>(node_i);
+  }
+
+  template <std::size_t ColumnI>
+  auto& edge(Index edge_i) {
+    return arena_->edges.template get<ColumnI>(edge_i);
+  }
+
+  template <std::size_t ColumnI>
+  const auto& edge(Index edge_i) const {
+    return arena_->edges.template get<ColumnI>(edge_i);
+  }
+
+  // What's left of the budgets of a Search.
+  struct Limits {
+    std::size_t nodes_limit;
+    std::size_t expansions_left_n;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // The budgets of a search by threads_n threads.
+  Limits NewLimits(const Config& config, std::size_t threads_n) const {
+    // Every thread may add a node per leaf before noticing the budget is
+    // spent, and parked speculations take their share.
+    std::size_t leaves_n = threads_n * config.leaf_batch_n;
+    std::size_t reserved_n = leaves_n + SpeculationsLimit(config);
+    if ((config.max_tree_nodes_n != 0)
+        && (config.max_tree_nodes_n < 2 * (reserved_n + 1))) {
+      LOG(FATAL) << "max_tree_nodes_n is too small for the number of search "
+                    "threads, leaf_batch_n and speculative_children_n.";
+    }
+    // A leaf starting a chain of forced moves adds the whole chain, which is
+    // taken to be no longer than the longest the tree has added, so long as
+    // that leaves more room than pruning frees.
+    if (config.skip_forced_moves && (config.max_tree_nodes_n != 0)) {
+      reserved_n = std::min(
+          reserved_n
+              + leaves_n * longest_chain_n_.load(std::memory_order_relaxed),
+          config.max_tree_nodes_n / 2 - 1);
+    }
+    return Limits{
+        .nodes_limit = (config.max_tree_nodes_n == 0)
+            ? std::numeric_limits<std::size_t>::max()
+            : config.max_tree_nodes_n - reserved_n,
+        .expansions_left_n = (config.max_search_nodes_n == 0)
+            ? std::numeric_limits<std::size_t>::max()
+            : config.max_search_nodes_n,
+        .deadline = 
+            (config.search_time_limit == std::chrono::microseconds::zero())
+                ? std::chrono::steady_clock::time_point::max()
+                : std::chrono::steady_clock::now() + config.search_time_limit};
+  }
+
+  // Runs up to simulations_n simulations, pruning the tree whenever it reaches
+  // limits.nodes_limit, until they're done or the search stops for another
+  // reason. If root_moves isn't empty, it holds the root move of each
+  // simulation. Updates root_i and limits, and returns the number of
+  // simulations run.
+  int SearchPruning(Index& root_i, const std::vector<GameNetwork*>& networks,
+                    const Config& config, int simulations_n,
+                    std::span<const int> root_moves, Limits& limits,
+                    absl::BitGenRef bitgen) {
+    int run_n = 0;
+    for (;;) {
+      std::size_t start_nodes_n = nodes_n();
+      std::size_t room_n = (start_nodes_n < limits.nodes_limit)
+          ? limits.nodes_limit - start_nodes_n
+          : 0;
+      run_n += SearchWithinLimit(
+          root_i, networks, config, simulations_n - run_n,
+          root_moves.empty() ? root_moves : root_moves.subspan(run_n),
+          (limits.expansions_left_n >= room_n)
+              ? limits.nodes_limit
+              : start_nodes_n + limits.expansions_left_n,
+          limits.deadline, bitgen);
+      std::size_t expanded_n = nodes_n() - start_nodes_n;
+      limits.expansions_left_n -= std::min(expanded_n,
+                                           limits.expansions_left_n);
+      if ((run_n >= simulations_n) || (limits.expansions_left_n == 0)
+          || (nodes_n() < limits.nodes_limit) || Stopped()
+          || (std::chrono::steady_clock::now() >= limits.deadline)) {
+        return run_n;
+      }
+      root_i = Prune(root_i, config.max_tree_nodes_n / 2 - 1);
+      // Searching on would only fill the tree and prune it again.
+      if (nodes_n() >= limits.nodes_limit) return run_n;
+    }
+  }
+
+  // Search with Gumbel sequential halving at the root; see
+  // Config::gumbel_considered_n.
+  //
+  // Visits the root already has count towards the rounds, as if they'd been
+  // part of this search: each round brings every move left up to the same
+  // number of visits, so moves that already have them aren't searched again.
+  Index SearchGumbel(Index root_i, const std::vector<GameNetwork*>& networks,
+                     const Config& config, int simulations_n, Limits& limits,
+                     absl::BitGenRef bitgen) {
+    int moves_n = this->moves_n(root_i);
+    gumbel_scores_.resize(moves_n);
+    gumbel_moves_i_.resize(moves_n);
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      // A standard Gumbel variable.
+      float gumbel = -std::logf(-std::logf(absl::Uniform(
+          absl::IntervalOpenOpen, bitgen, 0.0f, 1.0f)));
+      gumbel_scores_[move_i] = gumbel + PriorLogit(edge_i(root_i, move_i));
+      gumbel_moves_i_[move_i] = move_i;
+    }
+    // Taking the top scores samples moves without replacement from the prior.
+    int considered_n = std::min(config.gumbel_considered_n, moves_n);
+    SortGumbelMoves(root_i, config, considered_n, false);
+
+    int rounds_n = std::max<int>(std::bit_width(unsigned(considered_n - 1)), 1);
+    int total_n = visit_sum(root_i) + simulations_n;
+    int target_n = 0;
+    for (int round_i = 0; round_i < rounds_n; ++round_i) {
+      int moves_left_n = gumbel_moves_i_.size();
+      // The last round spends whatever is left.
+      target_n = (round_i == rounds_n - 1)
+          ? std::numeric_limits<int>::max()
+          : target_n + std::max(total_n / (rounds_n * moves_left_n), 1);
+
+      // Moves take turns so that a round cut short is still spread evenly, and
+      // so that search threads working through it at once tend to search
+      // different moves.
+      gumbel_schedule_.clear();
+      int scheduled_n = 0;
+      for (int extra_n = 0; scheduled_n < simulations_n; ++extra_n) {
+        int last_scheduled_n = scheduled_n;
+        for (int move_i : gumbel_moves_i_) {
+          if (scheduled_n == simulations_n) break;
+          if (visits_n(edge_i(root_i, move_i)) + extra_n < target_n) {
+            gumbel_schedule_.push_back(move_i);
+            ++scheduled_n;
+          }
+        }
+        if (scheduled_n == last_scheduled_n) break;
+      }
+      if (scheduled_n > 0) {
+        int run_n = SearchPruning(root_i, networks, config, scheduled_n,
+                                  gumbel_schedule_, limits, bitgen);
+        simulations_n -= run_n;
+        if (run_n < scheduled_n) break;
+      }
+      SortGumbelMoves(root_i, config, (moves_left_n + 1) / 2, true);
+    }
+    return root_i;
+  }
+
+  // Keeps the keep_n moves of gumbel_moves_i_ with the greatest Gumbel scores,
+  // including the transformed outcomes of the moves if with_outcomes.
+  void SortGumbelMoves(Index root_i, const Config& config, int keep_n,
+                       bool with_outcomes) {
+    std::vector<float> scores(gumbel_scores_);
+    if (with_outcomes) {
+      std::vector<float> outcomes;
+      CompletedOutcomes(root_i, outcomes);
+      int max_visits_n = MaxVisitsN(root_i);
+      for (int move_i : gumbel_moves_i_) {
+        scores[move_i] += GumbelTransform(outcomes[move_i], max_visits_n,
+                                          config);
+      }
+    }
+    std::partial_sort(gumbel_moves_i_.begin(), gumbel_moves_i_.begin() + keep_n,
+                      gumbel_moves_i_.end(), [&scores](int a, int b) {
+                            return scores[a] > scores[b];
+                          });
+    gumbel_moves_i_.resize(keep_n);
+  }
+
+  // The outcome of each root move for the player making it, in move order, with
+  // the root's mixed value estimate standing in for moves that haven't been
+  // visited: the network's predicted outcome averaged with the prior-weighted
+  // outcome of the visited moves, weighted by the root's visit sum.
+  void CompletedOutcomes(Index root_i, std::vector<float>& outcomes) const {
+    int moves_n = this->moves_n(root_i);
+    outcomes.resize(moves_n);
+    float visited_prior_sum = 0.0f;
+    float visited_outcome_sum = 0.0f;
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      Index edge_i = this->edge_i(root_i, move_i);
+      float proven_outcome = 
+          edge<kEdgeProvenOutcome>(edge_i).load(std::memory_order_relaxed);
+      outcomes[move_i] = (proven_outcome != kUnprovenOutcome)
+          ? proven_outcome
+          : outcome(edge_i);
+      if (visits_n(edge_i) > 0) {
+        visited_prior_sum += prior(edge_i);
+        visited_outcome_sum += prior(edge_i) * outcomes[move_i];
+      }
+    }
+    float value = predicted_outcome(root_i)[node<kNodePlayerI>(root_i)];
+    float visit_sum = static_cast<float>(this->visit_sum(root_i));
+    if (visited_prior_sum > 0.0f) {
+      value = (value + visit_sum * visited_outcome_sum / visited_prior_sum)
+          / (1.0f + visit_sum);
+    }
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      if (visits_n(edge_i(root_i, move_i)) == 0) outcomes[move_i] = value;
+    }
+  }
+
+  int MaxVisitsN(Index root_i) const {
+    int max_visits_n = 0;
+    for (int move_i = 0; move_i < moves_n(root_i); ++move_i) {
+      max_visits_n = std::max(max_visits_n, visits_n(edge_i(root_i, move_i)));
+    }
+    return max_visits_n;
+  }
+
+  static inline float GumbelTransform(float outcome, int max_visits_n,
+                                      const Config& config) {
+    return (config.gumbel_visit_scale + static_cast<float>(max_visits_n))
+        * config.gumbel_value_scale * outcome;
+  }
+
+  // Whether searches have been asked to stop; see set_stop.
+  bool Stopped() const {
+    return (stop_ != nullptr) && stop_->load(std::memory_order_relaxed);
+  }
+
+  // The log of an edge's prior, kept finite.
+  float PriorLogit(Index edge_i) const {
+    return std::logf(std::max(prior(edge_i),
+                              std::numeric_limits<float>::min()));
+  }
+
+  // Runs up to simulations_n simulations as in Search, stopping early once the
+  // tree holds nodes_limit nodes, the deadline passes, searches are stopped,
+  // or the search can stop early, in which case early_stopped_n_ is set to
+  // the simulations left. If root_moves isn't empty, it holds the root move of
+  // each simulation. Returns the number of simulations run.
+  int SearchWithinLimit(
+      Index root_i, const std::vector<GameNetwork*>& networks,
+      const Config& config, int simulations_n, std::span<const int> root_moves,
+      std::size_t nodes_limit, std::chrono::steady_clock::time_point deadline,
+      absl::BitGenRef bitgen) {
+    // Threads claim simulations before running a round, and hand back the ones
+    // they didn't complete.
+    std::atomic<int> claimed_n(0);
+    std::atomic<bool> leader_secure(false);
+    auto search_fn = [&](GameNetwork* network, Worker& worker,
+                         absl::BitGenRef bitgen) {
+          typename InferenceService::Producer producer(inference_service_);
+          for (;;) {
+            if (nodes_n() >= nodes_limit) return;
+            if (config.solve && proven(root_i)) return;
+            if (Stopped()) return;
+            // The root needs a visit to have anything to report.
+            if ((visit_sum(root_i) > 0)
+                && (std::chrono::steady_clock::now() >= deadline)) {
+              return;
+            }
+            int claim_i = claimed_n.fetch_add(config.leaf_batch_n,
+                                              std::memory_order_relaxed);
+            if ((claim_i < simulations_n) && config.early_stop
+                && root_moves.empty()
+                && LeaderSecure(root_i, config.early_stop_margin, 
+                                simulations_n - claim_i)) {
+              leader_secure.store(true, std::memory_order_relaxed);
+            }
+            if ((claim_i >= simulations_n)
+                || leader_secure.load(std::memory_order_relaxed)) {
+              claimed_n.fetch_sub(config.leaf_batch_n,
+                                  std::memory_order_relaxed);
+              return;
+            }
+            int batch_n = std::min(config.leaf_batch_n,
+                                   simulations_n - claim_i);
+            int completed_n = Search(
+                root_i, network, config, batch_n, bitgen, worker,
+                root_moves.empty()
+                    ? root_moves
+                    : root_moves.subspan(claim_i, batch_n));
+            claimed_n.fetch_sub(config.leaf_batch_n - completed_n,
+                                std::memory_order_relaxed);
+            // Nothing completes while the only leaves worth visiting are being
+            // evaluated by other threads.
+            if (completed_n == 0) std::this_thread::yield();
+          }
+        };
+
+    std::size_t helpers_n = networks.size() - 1;
+    while (helper_workers_.size() < helpers_n) {
+      helper_workers_.emplace_back();
+      helper_bitgens_.emplace_back();
+    }
+    if ((helpers_n > 0) && ((helper_queue_ == nullptr)
+                            || (helper_queue_->threads_n() < helpers_n))) {
+      helper_queue_ = std::make_unique<mcts::internal::WorkQueue>(helpers_n,
+                                                                  helpers_n);
+    }
+    for (std::size_t i = 1; i < networks.size(); ++i) {
+      helper_queue_->AddWork(std::make_unique<HelperSearchFn>([&, i] {
+            search_fn(networks[i], helper_workers_[i - 1],
+                      helper_bitgens_[i - 1]);
+          }));
+    }
+    search_fn(networks[0], worker_, bitgen);
+    if (helpers_n > 0) helper_queue_->Drain();
+    int run_n = claimed_n.load(std::memory_order_relaxed);
+    early_stopped_n_ = leader_secure.load(std::memory_order_relaxed)
+        ? simulations_n - run_n
+        : 0;
+    return run_n;
+  }
+
+  // Whether the most visited edge at the root would stay the most visited even
+  // if margin of the remaining_n simulations went to the runner-up.
+  bool LeaderSecure(Index root_i, float margin, int remaining_n) const {
+    const std::atomic<int>* visits = 
+        &edge<kEdgeVisitsN>(node<kNodeFirstEdgeI>(root_i));
+    int first_n = 0;
+    int second_n = 0;
+    for (int i = 0; i < moves_n(root_i); ++i) {
+      int visits_n = visits[i].load(std::memory_order_relaxed);
+      if (visits_n > first_n) {
+        second_n = first_n;
+        first_n = visits_n;
+      } else if (visits_n > second_n) {
+        second_n = visits_n;
+      }
+    }
+    return static_cast<float>(first_n - second_n) 
+        > margin * static_cast<float>(remaining_n);
+  }
+
+  // The first half of a search round (see Search): makes up to leaf_batch_n
+  // descents, leaving the leaves they reach in worker.pending_games. Returns
+  // the number of simulations made.
+  int StartRound(Index root_i, const Config& config, int leaf_batch_n,
+                 absl::BitGenRef bitgen, Worker& worker,
+                 std::span<const int> root_moves = {}) {
+    worker.pending_games.clear();
+    worker.pending_edges_i.clear();
+    worker.pending_paths.clear();
+    worker.pending_path_ends.clear();
+    worker.pending_forced_games.clear();
+    worker.pending_forced_ends.clear();
+
+    int simulations_n = 0;
+    for (int leaf_i = 0; leaf_i < leaf_batch_n; ++leaf_i) {
+      int root_move_i = root_moves.empty() ? -1 : root_moves[leaf_i];
+      if (!Descend(root_i, config, root_move_i, bitgen, worker)) break;
+      ++simulations_n;
+    }
+
+    // Speculative states queued before the tree was last laid out again are
+    // for edges that no longer exist.
+    worker.speculating_edges_i.clear();
+    if (worker.speculative_layout_n == layout_n_) {
+      for (Game& game : worker.speculative_games) {
+        worker.pending_games.push_back(std::move(game));
+      }
+      std::swap(worker.speculating_edges_i, worker.speculative_edges_i);
+    }
+    worker.speculative_games.clear();
+    worker.speculative_edges_i.clear();
+    return simulations_n;
+  }
+
+  // The second half of a search round: adds the pending leaves to the tree
+  // with worker.pending_evaluations, which must be filled in, backs them up,
+  // and parks the round's speculative evaluations. If speculate, queues the
+  // children of the new nodes for speculative evaluation in the next round.
+  void FinishRound(const Config& config, bool speculate,
+                   absl::BitGenRef bitgen, Worker& worker) {
+    std::size_t leaves_n = worker.pending_edges_i.size();
+    std::size_t path_start_i = 0;
+    std::size_t forced_start_i = 0;
+    for (std::size_t i = 0; i < leaves_n; ++i) {
+      std::size_t forced_end_i = worker.pending_forced_ends[i];
+      if (worker.pending_edges_i[i] != kBarren) {
+        Index edge_i = AddForcedChain(
+            worker.pending_forced_games, forced_start_i, forced_end_i,
+            worker.pending_edges_i[i], worker.pending_evaluations[i].outcome,
+            !config.open_loop, worker);
+        Index node_i = AddNode(std::move(worker.pending_games[i]), edge_i,
+                               &(worker.pending_evaluations[i]),
+                               !config.open_loop);
+        if (speculate) {
+          QueueSpeculations(node_i, config.speculative_children_n, bitgen,
+                            worker);
+        }
+      }
+      std::size_t path_end_i = worker.pending_path_ends[i];
+      Backup(std::span<const Index>(
+                 worker.pending_paths.data() + path_start_i,
+                 path_end_i - path_start_i),
+             worker.pending_evaluations[i].outcome);
+      path_start_i = path_end_i;
+      forced_start_i = forced_end_i;
+    }
+    for (std::size_t i = 0; i < worker.speculating_edges_i.size(); ++i) {
+      Index edge_i = worker.speculating_edges_i[i];
+      // A descent may have expanded the edge in the meantime.
+      if (child_i(edge_i) != kBarren) continue;
+      ParkSpeculation(edge_i, std::move(worker.pending_games[leaves_n + i]),
+                      std::move(worker.pending_evaluations[leaves_n + i]),
+                      SpeculationsLimit(config));
+    }
+  }
+
+  // Queues the ongoing states of the children_n highest prior moves of the
+  // node at node_i for speculative evaluation in the worker's next round.
+  void QueueSpeculations(Index node_i, int children_n, absl::BitGenRef bitgen,
+                         Worker& worker) {
+    int moves_n = this->moves_n(node_i);
+    children_n = std::min(children_n, moves_n);
+    if (children_n == 0) return;
+    Index first_edge_i = node<kNodeFirstEdgeI>(node_i);
+    worker.speculative_moves_i.resize(moves_n);
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      worker.speculative_moves_i[move_i] = move_i;
+    }
+    std::partial_sort(
+        worker.speculative_moves_i.begin(),
+        worker.speculative_moves_i.begin() + children_n,
+        worker.speculative_moves_i.end(), [&](int a, int b) {
+              return prior(first_edge_i + a) > prior(first_edge_i + b);
+            });
+    if (worker.speculative_games.empty()) {
+      worker.speculative_layout_n = layout_n_;
+    }
+    for (int i = 0; i < children_n; ++i) {
+      int move_i = worker.speculative_moves_i[i];
+      Game child_game(game(node_i));
+      if constexpr (games::DeterministicGameType<Game>) {
+        child_game.MakeMove(move_i);
+      } else {
+        child_game.MakeMove(move_i, bitgen);
+      }
+      // Terminal states are never sent to the network anyway.
+      if (child_game.State() == games::GameState::kOver) continue;
+      worker.speculative_games.push_back(std::move(child_game));
+      worker.speculative_edges_i.push_back(first_edge_i + move_i);
+    }
+  }
+
+  // Walks down from the root applying virtual loss until either a leaf is
+  // queued for evaluation, or a proven or already evaluated state is reached
+  // and backed up immediately. The move at the root is root_move_i, or chosen
+  // like any other if -1. If config.open_loop, the moves are replayed from the
+  // root's game along the way.
+  //
+  // Returns false (with the virtual loss undone) if the descent collided with a
+  // leaf some thread is already evaluating.
+  bool Descend(Index root_i, const Config& config, int root_move_i,
+               absl::BitGenRef bitgen, Worker& worker) {
+    worker.path.clear();
+    if (config.open_loop) worker.game.emplace(game(root_i));
+    Index node_i = root_i;
+    for (;;) {
+      int children_n = moves_n(node_i);
+      float visit_sum_sqrt = std::sqrtf(static_cast<float>(
+          visit_sum(node_i)));
+
+      // A node's edges are contiguous in every column.
+      Index first_edge_i = node<kNodeFirstEdgeI>(node_i);
+      const float* priors = &edge<kEdgePrior>(first_edge_i);
+
+      int max_move_i;
+      if ((node_i == root_i) && (root_move_i != -1)) {
+        max_move_i = root_move_i;
+      } else {
+        // Selecting an edge *at* the root is a little more involved since we
+        // have to factor in some exploration noise.
+        if ((node_i == root_i) && (config.root_noise_lerp != 0.0f)) {
+          if (config.root_noise_per_move) {
+            priors = root_priors_.data();
+          } else {
+            MixRootNoise(root_i, config, bitgen, worker.noise,
+                         worker.root_priors);
+            priors = worker.root_priors.data();
+          }
+        }
+        max_move_i = SelectEdge(
+            children_n, priors, &edge<kEdgeVisitsN>(first_edge_i),
+            &edge<kEdgeOutcomeSum>(first_edge_i),
+            &edge<kEdgeProvenOutcome>(first_edge_i),
+            config.exploration_scale * visit_sum_sqrt, bitgen, worker);
+      }
+
+      Index max_edge_i = first_edge_i + max_move_i;
+      AddVirtualLoss(max_edge_i);
+      worker.path.push_back(max_edge_i);
+
+      // Now either traverse the edge, expand it, or just pass its value up if
+      // it's terminal.
+      std::atomic<Index>& max_edge_child_i = edge<kEdgeChildI>(max_edge_i);
+      Index child_i = max_edge_child_i.load(std::memory_order_acquire);
+      if (child_i == kBarren) {
+        // If another thread claims the edge first, child_i is updated to
+        // whatever it set.
+        if (max_edge_child_i.compare_exchange_strong(
+                child_i, kPending, std::memory_order_acquire)) {
+          // A speculatively evaluated state stands in for the move's result.
+          std::optional<Speculation> speculation = 
+              (config.speculative_children_n > 0)
+                  ? TakeSpeculation(max_edge_i)
+                  : std::nullopt;
+          Game expanded_game = speculation
+              ? std::move(speculation->game)
+              : config.open_loop ? std::move(*worker.game) : game(node_i);
+          if (!speculation) {
+            if constexpr (games::DeterministicGameType<Game>) {
+              expanded_game.MakeMove(max_move_i);
+            } else {
+              expanded_game.MakeMove(max_move_i, bitgen);
+            }
+          }
+          if constexpr (games::HashableGameType<Game>) {
+            std::size_t found_i = config.open_loop
+                ? mcts::internal::TranspositionTable::kAbsent
+                : transpositions_.FindOrClaim(expanded_game.Hash());
+            if (found_i == mcts::internal::TranspositionTable::kPending) {
+              // Some other edge leads to the same state, and it's still being
+              // evaluated. Give the edge back and try again later.
+              max_edge_child_i.store(kBarren, std::memory_order_release);
+              RevertVirtualLoss(worker.path);
+              return false;
+            }
+            if (found_i != mcts::internal::TranspositionTable::kAbsent) {
+              // The state has been reached before, so it has an outcome we
+              // can use without the network.
+              max_edge_child_i.store(found_i, std::memory_order_release);
+              Backup(worker.path, LeafOutcome(found_i));
+              if (config.solve) PropagateProofs(worker.path);
+              return true;
+            }
+          }
+          // Terminal states don't need the network, so there's no reason to
+          // defer them.
+          if (expanded_game.State() == games::GameState::kOver) {
+            Index leaf_i = AddNode(std::move(expanded_game), max_edge_i,
+                                   nullptr, !config.open_loop);
+            Backup(worker.path, predicted_outcome(leaf_i));
+            if (config.solve) PropagateProofs(worker.path);
+            return true;
+          }
+          if (speculation) {
+            AddNode(std::move(expanded_game), max_edge_i,
+                    &(speculation->evaluation), true);
+            Backup(worker.path, speculation->evaluation.outcome);
+            return true;
+          }
+          if (config.skip_forced_moves
+              && (expanded_game.CurrentMovesN() == 1)) {
+            return ExpandForced(std::move(expanded_game), max_edge_i, config,
+                                bitgen, worker);
+          }
+          QueueLeaf(std::move(expanded_game), max_edge_i, worker);
+          return true;
+        }
+      }
+      if (child_i == kPending) {
+        RevertVirtualLoss(worker.path);
+        return false;
+      }
+
+      node_i = child_i;
+      if (config.open_loop) {
+        if constexpr (games::DeterministicGameType<Game>) {
+          worker.game->MakeMove(max_move_i);
+        } else {
+          worker.game->MakeMove(max_move_i, bitgen);
+        }
+        bool over = worker.game->State() == games::GameState::kOver;
+        if (!Matches(node_i, *worker.game)) {
+          // The chance events drawn this time led somewhere the node can't
+          // stand for, so the state is scored on its own.
+          if (over) {
+            Backup(worker.path, worker.game->Outcome());
+            return true;
+          }
+          if (config.skip_forced_moves 
+              && (worker.game->CurrentMovesN() == 1)) {
+            return ExpandForced(std::move(*worker.game), kBarren, config,
+                                bitgen, worker);
+          }
+          QueueLeaf(std::move(*worker.game), kBarren, worker);
+          return true;
+        }
+        if (over) {
+          // The outcome may differ from the one the node was created with.
+          Backup(worker.path, worker.game->Outcome());
+          if (config.solve) PropagateProofs(worker.path);
+          return true;
+        }
+      }
+
+      // There's nothing to learn below a proven node, so it's treated like a
+      // terminal one.
+      if (proven(node_i)) {
+        Backup(worker.path, proven_outcome(node_i));
+        if (config.solve) PropagateProofs(worker.path);
+        return true;
+      }
+    }
+  }
+
+  // Queues the leaf state reached by the worker's descent for evaluation. It's
+  // added to the tree at the end of edge_i, unless that's kBarren, after any
+  // forced states ExpandForced queued for it.
+  static void QueueLeaf(Game&& game, Index edge_i, Worker& worker) {
+    worker.pending_games.push_back(std::move(game));
+    worker.pending_edges_i.push_back(edge_i);
+    worker.pending_paths.insert(worker.pending_paths.end(),
+                                worker.path.begin(), worker.path.end());
+    worker.pending_path_ends.push_back(worker.pending_paths.size());
+    worker.pending_forced_ends.push_back(worker.pending_forced_games.size());
+  }
+
+  // Expands the forced state game reached by the worker's descent at the end
+  // of edge_i (kBarren if it isn't to be added) together with the chain of
+  // forced moves that follows it. Only the first state of the chain with a
+  // choice of moves is evaluated, or none if the chain ends the game or runs
+  // into a state already in the tree, and the forced states are added with
+  // its outcome. Returns as Descend does.
+  //
+  // Like game, which the descent has claimed, the states that follow it are
+  // claimed in the transposition table as they're reached. If another descent
+  // is adding one of them, the claims are given back along with edge_i.
+  bool ExpandForced(Game&& game, Index edge_i, const Config& config,
+                    absl::BitGenRef bitgen, Worker& worker) {
+    bool transpose = false;
+    if constexpr (games::HashableGameType<Game>) {
+      transpose = !config.open_loop && (edge_i != kBarren);
+    }
+    std::vector<Game>& chain = worker.pending_forced_games;
+    std::size_t chain_start_i = chain.size();
+    chain.push_back(std::move(game));
+    std::size_t found_i = mcts::internal::TranspositionTable::kAbsent;
+    while ((chain.back().State() == games::GameState::kOngoing)
+           && (chain.back().CurrentMovesN() == 1)) {
+      Game next_game(chain.back());
+      if constexpr (games::DeterministicGameType<Game>) {
+        next_game.MakeMove(0);
+      } else {
+        next_game.MakeMove(0, bitgen);
+      }
+      if constexpr (games::HashableGameType<Game>) {
+        if (transpose) {
+          found_i = transpositions_.FindOrClaim(next_game.Hash());
+        }
+      }
+      if (found_i == mcts::internal::TranspositionTable::kPending) {
+        if constexpr (games::HashableGameType<Game>) {
+          for (std::size_t i = chain_start_i; i < chain.size(); ++i) {
+            transpositions_.Release(chain[i].Hash());
+          }
+        }
+        while (chain.size() > chain_start_i) chain.pop_back();
+        edge<kEdgeChildI>(edge_i).store(kBarren, std::memory_order_release);
+        RevertVirtualLoss(worker.path);
+        return false;
+      }
+      if (found_i != mcts::internal::TranspositionTable::kAbsent) break;
+      chain.push_back(std::move(next_game));
+    }
+
+    if (found_i != mcts::internal::TranspositionTable::kAbsent) {
+      // The state after the chain is in the tree already, and stands in for
+      // its end.
+      CountChain(chain.size() - chain_start_i);
+      auto outcome = LeafOutcome(found_i);
+      Index last_edge_i = AddForcedChain(chain, chain_start_i, chain.size(),
+                                         edge_i, outcome, true, worker);
+      edge<kEdgeChildI>(last_edge_i).store(found_i,
+                                           std::memory_order_release);
+      if (config.solve) PropagateProofs(worker.forced_edges_i);
+      while (chain.size() > chain_start_i) chain.pop_back();
+      Backup(worker.path, outcome);
+      if (config.solve) PropagateProofs(worker.path);
+      return true;
+    }
+    Game end_game(std::move(chain.back()));
+    chain.pop_back();
+    CountChain(chain.size() - chain_start_i);
+
+    if (end_game.State() == games::GameState::kOngoing) {
+      QueueLeaf(std::move(end_game), edge_i, worker);
+      return true;
+    }
+    // Nothing in the chain needs the network.
+    auto outcome = end_game.Outcome();
+    if (edge_i != kBarren) {
+      Index last_edge_i = AddForcedChain(chain, chain_start_i, chain.size(),
+                                         edge_i, outcome, !config.open_loop,
+                                         worker);
+      AddNode(std::move(end_game), last_edge_i, nullptr, !config.open_loop);
+      if (config.solve) PropagateProofs(worker.forced_edges_i);
+    }
+    while (chain.size() > chain_start_i) chain.pop_back();
+    Backup(worker.path, outcome);
+    if (config.solve && (edge_i != kBarren)) PropagateProofs(worker.path);
+    return true;
+  }
+
+  // Counts a chain of chain_n forced states towards collapsed_n and
+  // longest_chain_n_.
+  void CountChain(std::size_t chain_n) {
+    collapsed_n_.fetch_add(chain_n, std::memory_order_relaxed);
+    std::size_t longest_n = longest_chain_n_.load(std::memory_order_relaxed);
+    while ((chain_n > longest_n)
+           && !longest_chain_n_.compare_exchange_weak(
+                  longest_n, chain_n, std::memory_order_relaxed)) {}
+  }
+
+  // Adds the forced states games[start_i, end_i) as a chain at the end of
+  // edge_i, each predicted to reach outcome and leading to the next by its
+  // only move. Returns the edge out of the last of them (edge_i if there are
+  // none), and leaves the edges out of them in worker.forced_edges_i.
+  Index AddForcedChain(std::vector<Game>& games, std::size_t start_i,
+                       std::size_t end_i, Index edge_i,
+                       const std::array<float, Game::players_n()>& outcome,
+                       bool keep_game, Worker& worker) {
+    worker.forced_edges_i.clear();
+    if (start_i == end_i) return edge_i;
+    Evaluation<Game> forced{.outcome = outcome, .policy = {1.0f}};
+    for (std::size_t i = start_i; i < end_i; ++i) {
+      Index node_i = AddNode(std::move(games[i]), edge_i, &forced, keep_game);
+      edge_i = node<kNodeFirstEdgeI>(node_i);
+      worker.forced_edges_i.push_back(edge_i);
+    }
+    return edge_i;
+  }
+
+  // Creates a node for the game state at the end of source_edge_i (kBarren for
+  // the root), along with its child edges, and publishes it to the edge. The
+  // evaluation is ignored for terminal states. The node keeps the game only if
+  // keep_game. Returns the new node index.
+  Index AddNode(Game&& game, Index source_edge_i,
+                const Evaluation<Game>* evaluation, bool keep_game) {
+    NodeArray& nodes = arena_->nodes;
+    EdgeArray& edges = arena_->edges;
+    Index node_i = CheckIndex(nodes.Allocate(1), 1);
+    const Game* node_game = &game;
+    if (keep_game) {
+      Index game_i = CheckIndex(arena_->games.Allocate(1), 1);
+      node_game = &arena_->games.template Emplace<0>(game_i, std::move(game));
+      nodes.template Emplace<kNodeGameI>(node_i, game_i);
+    } else {
+      nodes.template Emplace<kNodeGameI>(node_i, kBarren);
+    }
+    nodes.template Emplace<kNodeVisitSum>(node_i, 0);
+    if (node_game->State() == games::GameState::kOver) {
+      nodes.template Emplace<kNodeFirstEdgeI>(node_i, kBarren);
+      nodes.template Emplace<kNodeMovesN>(node_i, 0);
+      nodes.template Emplace<kNodePlayerI>(node_i, 0);
+      nodes.template Emplace<kNodePredictedOutcome>(node_i,
+                                                    node_game->Outcome());
+      nodes.template Emplace<kNodeProof>(node_i, kProven);
+      nodes.template Emplace<kNodeProvenOutcome>(node_i, node_game->Outcome());
+    } else {
+      std::size_t moves_n = evaluation->policy.size();
+      Index first_edge_i = CheckIndex(edges.Allocate(moves_n), moves_n);
+      for (std::size_t i = 0; i < moves_n; ++i) {
+        Index edge_i = first_edge_i + i;
+        edges.template Emplace<kEdgePrior>(edge_i, evaluation->policy[i]);
+        edges.template Emplace<kEdgeVisitsN>(edge_i, 0);
+        edges.template Emplace<kEdgeOutcomeSum>(edge_i, 0.0f);
+        edges.template Emplace<kEdgeChildI>(edge_i, kBarren);
+        edges.template Emplace<kEdgeParentI>(edge_i, node_i);
+        edges.template Emplace<kEdgeProvenOutcome>(edge_i, kUnprovenOutcome);
+      }
+      nodes.template Emplace<kNodeFirstEdgeI>(node_i, first_edge_i);
+      nodes.template Emplace<kNodeMovesN>(node_i, moves_n);
+      nodes.template Emplace<kNodePlayerI>(node_i,
+                                           node_game->CurrentPlayerI());
+      nodes.template Emplace<kNodePredictedOutcome>(node_i,
+                                                    evaluation->outcome);
+      nodes.template Emplace<kNodeProof>(node_i, kUnproven);
+      nodes.template Emplace<kNodeProvenOutcome>(node_i);
+    }
+
+    if constexpr (games::HashableGameType<Game>) {
+      if (keep_game) transpositions_.Set(node_game->Hash(), node_i);
+    }
+    if (source_edge_i != kBarren) {
+      edge<kEdgeChildI>(source_edge_i).store(node_i,
+                                             std::memory_order_release);
+    }
+    return node_i;
+  }
+
+  // Fails if a range of n indices from first_i would run into the reserved
+  // index values.
+  static inline Index CheckIndex(std::size_t first_i, std::size_t n) {
+    if (first_i + n > kPending) {
+      LOG(FATAL) << "The search tree has outgrown its 32-bit indices.";
+    }
+    return first_i;
+  }
+
+  // Counts a visit to edge_i before its outcome is known.
+  void AddVirtualLoss(Index edge_i) {
+    edge<kEdgeVisitsN>(edge_i).fetch_add(1, std::memory_order_relaxed);
+    node<kNodeVisitSum>(edge<kEdgeParentI>(edge_i)).fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  // Undoes the virtual loss of every edge along a path.
+  void RevertVirtualLoss(std::span<const Index> path) {
+    for (Index edge_i : path) {
+      edge<kEdgeVisitsN>(edge_i).fetch_sub(1, std::memory_order_relaxed);
+      node<kNodeVisitSum>(edge<kEdgeParentI>(edge_i)).fetch_sub(
+          1, std::memory_order_relaxed);
+    }
+  }
+
+  // Propagates a leaf outcome along the path of edges that reached it. Visits
+  // were already counted on the way down.
+  void Backup(std::span<const Index> path,
+              const std::array<float, Game::players_n()>& leaf_outcome) {
+    for (Index edge_i : path) {
+      int player_i = node<kNodePlayerI>(edge<kEdgeParentI>(edge_i));
+      edge<kEdgeOutcomeSum>(edge_i).fetch_add(leaf_outcome[player_i],
+                                              std::memory_order_relaxed);
+    }
+  }
+
+  // The outcome to back up from a node reached through a transposition.
+  const std::array<float, Game::players_n()>& LeafOutcome(Index node_i) const {
+    return proven(node_i) ? proven_outcome(node_i) : predicted_outcome(node_i);
+  }
+
+  // Called after backing up a proven leaf: working up from the bottom of the
+  // path, records each proven child's outcome on the edge leading to it, and
+  // tries to prove the edge's parent in turn.
+  void PropagateProofs(std::span<const Index> path) {
+    if constexpr (games::NonDeterministicGameType<Game>) {
+      // A child is only one draw of the chance events behind its move, so the
+      // move's outcome isn't settled by the child's.
+      return;
+    } else {
+      for (auto edge_i = path.rbegin(); edge_i != path.rend(); ++edge_i) {
+        Index child_i = this->child_i(*edge_i);
+        if ((child_i == kBarren) || (child_i == kPending) 
+            || !proven(child_i)) {
+          return;
+        }
+        Index parent_i = edge<kEdgeParentI>(*edge_i);
+        edge<kEdgeProvenOutcome>(*edge_i).store(
+            proven_outcome(child_i)[node<kNodePlayerI>(parent_i)],
+            std::memory_order_relaxed);
+        if (!TryProve(parent_i)) return;
+      }
+    }
+  }
+
+  // Proves a node if one of its moves is proven to win outright for the player
+  // making it, or if every move is proven, in which case the node takes the
+  // best outcome among them. Returns whether the node is proven.
+  bool TryProve(Index node_i) {
+    std::atomic<uint8_t>& proof = node<kNodeProof>(node_i);
+    if (proof.load(std::memory_order_acquire) == kProven) return true;
+    int player_i = node<kNodePlayerI>(node_i);
+    int best_move_i = -1;
+    float best_outcome = kUnprovenOutcome;
+    bool all_proven = true;
+    for (int move_i = 0; move_i < moves_n(node_i); ++move_i) {
+      Index edge_i = this->edge_i(node_i, move_i);
+      float outcome = 
+          edge<kEdgeProvenOutcome>(edge_i).load(std::memory_order_relaxed);
+      if (outcome == kUnprovenOutcome) {
+        // The child may have been proven by a descent through another of its
+        // parents.
+        Index child_i = this->child_i(edge_i);
+        if ((child_i == kBarren) || (child_i == kPending)
+            || !proven(child_i)) {
+          all_proven = false;
+          continue;
+        }
+        outcome = proven_outcome(child_i)[player_i];
+        edge<kEdgeProvenOutcome>(edge_i).store(outcome,
+                                               std::memory_order_relaxed);
+      }
+      if (outcome > best_outcome) {
+        best_outcome = outcome;
+        best_move_i = move_i;
+      }
+    }
+    // Outcomes sum to 1, so nothing beats an outcome of 1.
+    if (!all_proven && (best_outcome < 1.0f)) return false;
+
+    uint8_t unproven = kUnproven;
+    if (!proof.compare_exchange_strong(unproven, kProving,
+                                       std::memory_order_acquire)) {
+      return false;
+    }
+    Index best_child_i = child_i(edge_i(node_i, best_move_i));
+    // Synchronizes with the child's proof before its outcome is read.
+    (void)proven(best_child_i);
+    node<kNodeProvenOutcome>(node_i) = proven_outcome(best_child_i);
+    proof.store(kProven, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the move of the edge with the greatest upper confidence bound,
+  // where exploration_factor already includes the square root of the parent's
+  // visit sum. The n edges' statistics are read from parallel arrays.
+  static int SelectEdge(int n, const float* priors,
+                        const std::atomic<int>* visits,
+                        const std::atomic<float>* outcome_sums,
+                        const std::atomic<float>* proven_outcomes,
+                        float exploration_factor, absl::BitGenRef bitgen,
+                        Worker& worker) {
+    if (worker.edge_values.size() < n) {
+      worker.edge_visits.resize(n);
+      worker.edge_outcome_sums.resize(n);
+      worker.edge_proven_outcomes.resize(n);
+      worker.edge_values.resize(n);
+    }
+    auto edge_visits = worker.edge_visits.head(n);
+    auto edge_outcome_sums = worker.edge_outcome_sums.head(n);
+    auto edge_proven_outcomes = worker.edge_proven_outcomes.head(n);
+    auto edge_values = worker.edge_values.head(n);
+    for (int i = 0; i < n; ++i) {
+      edge_visits[i] = static_cast<float>(
+          visits[i].load(std::memory_order_relaxed));
+      edge_outcome_sums[i] = outcome_sums[i].load(std::memory_order_relaxed);
+      edge_proven_outcomes[i] = 
+          proven_outcomes[i].load(std::memory_order_relaxed);
+    }
+
+    // We consider the outcome to be the projection from whoever's turn it is,
+    // giving us our min-max like behavior. Unvisited edges have no outcome
+    // sum, so they come out at 0. Proven outcomes replace the mean, and moves
+    // proven to lose are only taken if nothing else is left.
+    edge_values = (edge_proven_outcomes == 0.0f).select(
+        -1.0f,
+        (edge_proven_outcomes >= 0.0f).select(
+            edge_proven_outcomes, edge_outcome_sums / edge_visits.max(1.0f))
+        + exploration_factor * Eigen::Map<const Eigen::ArrayXf>(priors, n)
+            / (edge_visits + 1.0f));
+    float max_value = edge_values.maxCoeff();
+
+    // To prevent favoring any particular move ordering when there are ties, we
+    // look for the best edge from a random starting point.
+    int start_i = absl::Uniform(bitgen, 0, n);
+    for (int i = start_i; i < n; ++i) {
+      if (edge_values[i] == max_value) return i;
+    }
+    for (int i = 0; i < start_i; ++i) {
+      if (edge_values[i] == max_value) return i;
+    }
+    return start_i;
+  }
+
+  // Interpolates fresh Dirichlet noise with the priors of the root's edges.
+  void MixRootNoise(Index root_i, const Config& config, absl::BitGenRef bitgen,
+                    std::vector<float>& noise,
+                    std::vector<float>& root_priors) const {
+    int children_n = moves_n(root_i);
+    noise.resize(children_n);
+    root_priors.resize(children_n);
+    DirichletNoise(noise, config.root_noise_alpha, bitgen);
+    const float* priors = &edge<kEdgePrior>(node<kNodeFirstEdgeI>(root_i));
+    for (int i = 0; i < children_n; ++i) {
+      root_priors[i] = (noise[i] - priors[i]) * config.root_noise_lerp
+          + priors[i];
+    }
+  }
+};
+
+static inline int SamplePolicy(const std::unique_ptr<float[]>& prop, int size, 
+                               absl::BitGenRef bitgen) {
+  int move_index = 0;
+
+  float uniform = absl::Uniform(bitgen, 0.0f, 1.0f);
+  float total = 0.0f;
+  float prev_total = total;
+  for (; move_index < size; ++move_index) {
+    total += prop[move_index];
+    if ((uniform >= prev_total) && (uniform < total)) break;
+    prev_total = total;
+  }
+  // Handle round-off errors.
+  return (move_index == size) ? size - 1 : move_index;
+}
+
+}  // namespace internal
 
-  // The predicted search probability along this edge.
-  float search_prob;
+template <games::AnyGameType Game>
+struct MoveOutcome {
+  // The outcome order-rotated s.t. the player who's move it is to make is in
+  // the first row.
+  //
+  // If not playing a full game, the value of this field is set by the outcome
+  // estimated at the root and is not rotated.
+  nn::Matrix<Game::players_n(), 1> outcome;
 
-  // The number of times this edge has been traversed.
-  int visits_n;
+  // The visit proportions across move options at the searched game state.
+  nn::DynamicMatrix search_policy;
 
-  // The source index of the parent node.
-  const std::size_t parent_i;
+  // The index of the policy head of the games::GameNetwork that search_policy
+  // applies to.
+  std::size_t search_policy_class_i;
 
-  // The source index of the child node. If -1, there is no child node at the
-  // other end, and this node is a candidate for expansion.
-  std::size_t child_i;
+  // The network inputs that should yield outcome and search_policy.
+  std::vector<nn::DynamicMatrix> state_inputs;
+};
 
-  bool barren() const {
-    return child_i == -1;
+// Sets the outcome of a move made by player_i in a game that ended with
+// outcome (in un-rotated player order), rotating it as MoveOutcome::outcome
+// describes: the inverse of how GameTree un-rotates the network's predictions.
+template <games::AnyGameType Game>
+void SetMoveOutcome(const std::array<float, Game::players_n()>& outcome,
+                    int player_i, MoveOutcome<Game>& move) {
+  for (int i = 0; i < Game::players_n(); ++i) {
+    move.outcome(i, 0) = outcome[(i + player_i) % Game::players_n()];
   }
+}
+
+// Takes the moves recorded by full self-play games as they're made, rather
+// than once each game is over, so that a consumer (a replay buffer, say, or a
+// writer) can start on them right away and needn't hold a whole game.
+//
+// A game's moves are added one at a time, their outcomes zero since the game
+// isn't over yet. Once it is, EndGame gives its outcome, which is what the
+// outcomes of its moves should be set to; see SetMoveOutcome. Games are told
+// apart by an index, since several may be played at once.
+//
+// Only called from the thread playing the games.
+template <games::AnyGameType Game>
+class MoveSink {
+ public:
+  virtual ~MoveSink() {}
+
+  // A move of game game_i, made by player_i.
+  virtual void AddMove(int game_i, int player_i, MoveOutcome<Game>&& move) = 0;
+
+  // Game game_i is over, with outcome in un-rotated player order. No more of
+  // its moves follow.
+  virtual void EndGame(
+      int game_i, const std::array<float, Game::players_n()>& outcome) = 0;
 };
 
+// A MoveSink that keeps every move in memory, grouped by game.
 template <games::AnyGameType Game>
-struct TreeNode {
-  TreeNode(Game&& game, std::size_t parent_i) :
-      game(std::move(game)), parent_i(parent_i) {
-    visit_sum = 0;
+class MoveCollector : public MoveSink<Game> {
+ public:
+  void AddMove(int game_i, int player_i, MoveOutcome<Game>&& move) override {
+    if (games_.size() <= static_cast<std::size_t>(game_i)) {
+      games_.resize(game_i + 1);
+    }
+    games_[game_i].moves.push_back(std::move(move));
+    games_[game_i].players_i.push_back(player_i);
+  }
+
+  void EndGame(int game_i,
+               const std::array<float, Game::players_n()>& outcome) override {
+    if (games_.size() <= static_cast<std::size_t>(game_i)) {
+      games_.resize(game_i + 1);
+    }
+    Moves& game = games_[game_i];
+    for (std::size_t i = 0; i < game.moves.size(); ++i) {
+      SetMoveOutcome(outcome, game.players_i[i], game.moves[i]);
+    }
+  }
+
+  // Returns the moves collected, one game after another, and forgets them.
+  std::vector<MoveOutcome<Game>> TakeMoves() {
+    std::vector<MoveOutcome<Game>> moves;
+    for (Moves& game : games_) {
+      for (auto& move : game.moves) moves.push_back(std::move(move));
+    }
+    games_.clear();
+    return moves;
   }
 
-  // The game state at this node. 
-  const Game game;
+ private:
+  // Parallel arrays.
+  struct Moves {
+    std::vector<MoveOutcome<Game>> moves;
+    std::vector<int> players_i;
+  };
+  std::vector<Moves> games_;
+};
+
+namespace internal {
+
+// Creates a MoveOutcome for the searched game with the given search policy (in
+// move order). The outcome is left for the caller to fill in.
+template <games::AnyGameType Game>
+MoveOutcome<Game> PolicyToMoveOutcome(
+    const Game& game, const std::unique_ptr<float[]>& search_policy) {
+  MoveOutcome<Game> move_outcome;
+  move_outcome.search_policy_class_i = game.PolicyClassI();
+  move_outcome.state_inputs = game.StateToMatrix();
+  move_outcome.search_policy = game.PolicyMask();
+  int move_i = 0;
+  for (int policy_vec_i = 0; policy_vec_i < move_outcome.search_policy.rows();
+      ++policy_vec_i) {
+    if (move_outcome.search_policy(policy_vec_i, 0) == 0.0f) continue;
+    move_outcome.search_policy(policy_vec_i, 0) = search_policy[move_i++];
+  }
+  return move_outcome;
+}
 
-  // The indices of the child edges for this move. These follow the same order
-  // as the moves in Game::MakeMove.
-  std::vector<std::size_t> children_i;
+}  // namespace internal
 
-  // The index of the parent edge. If -1, this is the root.
-  std::size_t parent_i;
-  
-  // The outcome predicted at this game state.
-  std::array<float, Game::players_n()> predicted_outcome;
+// A search of one game position that persists as moves are made, so that the
+// subtree below each move made is kept for the searches that follow.
+//
+// The position is searched with config.root_trees_n independent trees, each on
+// its own thread and grown by config.search_threads_n networks. Their root
+// visit counts are summed before being normalized into the search policy, and
+// their predicted root outcomes are averaged.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork>
+class SearchSession {
+ public:
+  SearchSession(const SearchSession&) = delete;
+  SearchSession& operator=(const SearchSession&) = delete;
 
-  // The sum of the visit counts (visits_n) of each edge.
-  int visit_sum;
+  SearchSession(const Config& config, const Game& game) :
+      config_(config), game_(std::make_unique<Game>(game)), moves_n_(0),
+      stop_pondering_(false), roots_i_(config.root_trees_n, kNoRoot) {
+    if (config.root_trees_n < 1) {
+      LOG(FATAL) << "Need at least one root tree.";
+    }
+    for (int i = 0; i < config.root_trees_n; ++i) {
+      trees_.push_back(std::make_unique<Tree>());
+      trees_.back()->set_evaluation_cache_n(config.evaluation_cache_n);
+      trees_.back()->set_stop(&stop_pondering_);
+    }
+  }
 
-  bool root() const {
-    return parent_i == -1;
+  ~SearchSession() {
+    StopPondering();
   }
 
-  bool terminal() const {
-    return children_i.empty();
+  // Has every tree evaluate with service; see GameTree::set_inference_service.
+  // Stops pondering.
+  void set_inference_service(typename internal::GameTree<
+      Game, GameNetwork>::InferenceService* service) {
+    StopPondering();
+    for (auto& tree : trees_) tree->set_inference_service(service);
   }
-};
 
-template <games::AnyGameType Game, games::GameNetworkType GameNetwork>
-class GameTree {
- public:
-  std::vector<TreeNode<Game>> nodes;
-  std::vector<TreeEdge<Game>> edges;
+  // Has every tree cache evaluations in cache, sized by
+  // config.evaluation_cache_n; see GameTree::set_evaluation_cache. Stops
+  // pondering.
+  void set_evaluation_cache(typename internal::GameTree<
+      Game, GameNetwork>::EvaluationCache* cache) {
+    StopPondering();
+    for (auto& tree : trees_) {
+      tree->set_evaluation_cache(cache);
+      tree->set_evaluation_cache_n(config_.evaluation_cache_n);
+    }
+  }
 
-  void Search(TreeNode<Game>* node, GameNetwork* network, 
-              float exploration_scale, float root_noise_alpha, 
-              float root_noise_lerp, absl::BitGenRef bitgen) {
+  // Searches until the root of every tree has config.simulations_n visits, so
+  // visits carried over from earlier searches aren't searched again. networks
+  // must hold SearchNetworksN(config) networks with the same weights.
+  //
+  // The outcome of the returned MoveOutcome is the (not rotated) outcome
+  // predicted at the root.
+  template <CallbacksType Callbacks>
+  MoveOutcome<Game> Search(const std::vector<GameNetwork*>& networks,
+                           ReplicaCallbacks<Callbacks>& callbacks) {
+    StopPondering();
+    if (game_->State() == games::GameState::kOver) {
+      LOG(FATAL) << "Cannot search a terminal state.";
+    }
+    if (networks.size()
+        < static_cast<std::size_t>(SearchNetworksN(config_))) {
+      LOG(FATAL) << "Need one network per search thread.";
+    }
+    callbacks.PreSearch();
+    const int moves_n = game_->CurrentMovesN();
+    bool skip_search = config_.skip_forced_moves && (moves_n == 1);
 
-    // Arrays we'll re-use during descent.
-    //
-    // Noise interpolated with the policy to encourage exploration.
-    std::vector<float> noise;
-    // A random ordering of candidate edges to visit.
-    std::vector<std::size_t> shuffled_seq;
+    // The simulations each tree skipped by stopping early, and the trees'
+    // collapsed_n before searching.
+    std::vector<int> saved_n(config_.root_trees_n, 0);
+    std::vector<std::size_t> collapsed_n(config_.root_trees_n, 0);
+    auto search_fn = [&](int tree_i, absl::BitGenRef bitgen) {
+          Tree& tree = *(trees_[tree_i]);
+          std::vector<GameNetwork*> tree_networks(
+              networks.begin() + tree_i * config_.search_threads_n,
+              networks.begin() + (tree_i + 1) * config_.search_threads_n);
+          if (roots_i_[tree_i] == kNoRoot) {
+            tree.clear();
+            roots_i_[tree_i] = tree.ExpandNode(Game(*game_), Tree::kBarren,
+                                               tree_networks[0]);
+          }
+          int visit_sum = tree.visit_sum(roots_i_[tree_i]);
+          int simulations_n = config_.simulations_n - visit_sum;
+          collapsed_n[tree_i] = tree.collapsed_n();
+          if ((simulations_n > 0) && !skip_search) {
+            roots_i_[tree_i] = tree.Search(roots_i_[tree_i], tree_networks,
+                                           config_, simulations_n, bitgen);
+            saved_n[tree_i] = tree.early_stopped_n();
+          }
+          collapsed_n[tree_i] = tree.collapsed_n() - collapsed_n[tree_i];
+        };
+    std::vector<std::thread> threads;
+    for (int tree_i = 1; tree_i < config_.root_trees_n; ++tree_i) {
+      threads.emplace_back([&, tree_i] {
+            absl::BitGen thread_bitgen;
+            search_fn(tree_i, thread_bitgen);
+          });
+    }
+    search_fn(0, bitgen_);
+    for (auto& thread : threads) thread.join();
 
-    // Step 1 is to explore the tree and find a leaf outcome to propagate up.
-    std::array<float, Game::players_n()> leaf_outcome;
-    for (;;) {
-      std::size_t children_n = node->children_i.size();
-
-      // Selecting an edge *at* the root is a little more involved since we have
-      // to factor in some exploration noise.
-      if (node->root()) {
-        noise.resize(children_n);
-        GameTree<Game, GameNetwork>::DirichletNoise(noise, root_noise_alpha, 
-                                                    bitgen);
-      }
-      float max_value = -1.0f;
-      TreeEdge<Game>* max_edge;
-      int max_edge_index;
-
-      // To prevent favoring any particular move ordering when there are ties,
-      // we always randomly permute the indices.
-      shuffled_seq.resize(children_n);
-      RandomSeq(shuffled_seq, bitgen);
-      for (std::size_t seq_i = 0; seq_i < children_n; ++seq_i) {
-        std::size_t child_i = shuffled_seq[seq_i];
-        TreeEdge<Game>& edge = edges[node->children_i[child_i]];
-        float policy_value = node->root()
-            ? (noise[child_i] - edge.search_prob) * root_noise_lerp
-                + edge.search_prob
-            : edge.search_prob; 
-        // We consider the outcome to be the projection from whoever's turn it
-        // is, giving us our min-max like behavior.
-        float edge_value = edge.outcome[node->game.CurrentPlayerI()]
-            + exploration_scale * policy_value * (
-                std::sqrtf(static_cast<float>(node->visit_sum))
-                    / static_cast<float>(1 + edge.visits_n));
-        if (edge_value > max_value) {
-          max_value = edge_value;
-
-          max_edge = &edge;
-          max_edge_index = child_i;
-        }  
-      }
-
-      // Now either traverse the edge, expand it, or just pass up its value up
-      // if it's terminal.
-      if (!max_edge->barren()) {
-        node = &(nodes[max_edge->child_i]);
-        if (node->terminal()) {
-          leaf_outcome = max_edge->outcome;
-          break;
+    auto search_policy = std::unique_ptr<float[]>(new float[moves_n]);
+    if (config_.gumbel_considered_n > 0) {
+      // Average the improved policies of the trees.
+      auto tree_policy = std::unique_ptr<float[]>(new float[moves_n]);
+      std::fill_n(search_policy.get(), moves_n, 0.0f);
+      for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+        trees_[tree_i]->GumbelPolicy(roots_i_[tree_i], config_,
+                                     tree_policy.get());
+        for (int move_i = 0; move_i < moves_n; ++move_i) {
+          search_policy[move_i] += tree_policy[move_i] 
+              / static_cast<float>(config_.root_trees_n);
         }
-      } else {
-        Game expanded_game(node->game);
-        if constexpr (games::DeterministicGameType<Game>) {
-          expanded_game.MakeMove(max_edge_index);
-        } else {
-          expanded_game.MakeMove(max_edge_index, bitgen);
+      }
+    } else {
+      float visit_sum = 0.0f;
+      for (int move_i = 0; move_i < moves_n; ++move_i) {
+        float visits_n = 0.0f;
+        for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+          const Tree& tree = *(trees_[tree_i]);
+          visits_n += static_cast<float>(
+              tree.visits_n(tree.edge_i(roots_i_[tree_i], move_i)));
         }
-        leaf_outcome = ExpandNode(std::move(expanded_game), 
-                                  node->children_i[max_edge_index], network);
-        node = &(nodes.back());
-        break;
+        search_policy[move_i] = visits_n;
+        visit_sum += visits_n;
+      }
+      for (int move_i = 0; move_i < moves_n; ++move_i) {
+        search_policy[move_i] /= visit_sum;
       }
     }
+    // The only move may not have been searched at all.
+    if (moves_n == 1) search_policy[0] = 1.0f;
 
-    // Step 2 is to propagate up leaf_outcome from node.
-    while (!node->root()) {
-      TreeEdge<Game>& parent_edge = edges[node->parent_i];
-      ++(parent_edge.visits_n);
-      for (int i = 0; i < Game::players_n(); ++i) {
-        parent_edge.acc_outcome[i] += leaf_outcome[i];
-        parent_edge.outcome[i] = parent_edge.acc_outcome[i] 
-            / static_cast<float>(parent_edge.visits_n);
+    // If any tree proved the position, its proof overrides the statistics.
+    int proven_tree_i = -1;
+    for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+      if (config_.solve && trees_[tree_i]->proven(roots_i_[tree_i])) {
+        proven_tree_i = tree_i;
+        break;
+      }
+    }
+    if (proven_tree_i != -1) {
+      int proven_move_i = trees_[proven_tree_i]->ProvenMoveI(
+          roots_i_[proven_tree_i]);
+      for (int move_i = 0; move_i < moves_n; ++move_i) {
+        search_policy[move_i] = (move_i == proven_move_i) ? 1.0f : 0.0f;
       }
-      node = &(nodes[parent_edge.parent_i]);
-      ++(node->visit_sum);
     }
-  }
-
-  const std::array<float, Game::players_n()>& ExpandNode(
-      Game&& expanded_game, std::size_t source_edge_i, GameNetwork* network) {
-    nodes.emplace_back(std::move(expanded_game), source_edge_i);
-    TreeNode<Game>& node = nodes.back();
-    std::size_t node_i = nodes.size() - 1;
 
-    if (!edges.empty()) {
-      edges[source_edge_i].child_i = node_i;
-      node.parent_i = source_edge_i;
+    MoveOutcome<Game> move_outcome = internal::PolicyToMoveOutcome(
+        *game_, search_policy);
+    move_outcome.outcome.setZero();
+    if (proven_tree_i != -1) {
+      const auto& root_outcome = trees_[proven_tree_i]->proven_outcome(
+          roots_i_[proven_tree_i]);
+      for (std::size_t player_i = 0; player_i < Game::players_n(); 
+          ++player_i) {
+        move_outcome.outcome(player_i, 0) = root_outcome[player_i];
+      }
     } else {
-      node.parent_i = -1;
+      for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+        const auto& root_outcome = 
+            trees_[tree_i]->predicted_outcome(roots_i_[tree_i]);
+        for (std::size_t player_i = 0; player_i < Game::players_n(); 
+            ++player_i) {
+          move_outcome.outcome(player_i, 0) += root_outcome[player_i];
+        }
+      }
+      move_outcome.outcome /= static_cast<float>(config_.root_trees_n);
     }
 
-    if (node.game.State() == games::GameState::kOver) {
-      node.predicted_outcome = node.game.Outcome();
-      return node.predicted_outcome;
-    } 
-
-    network->SetConstants(network->input_constant_indices(), 
-                          node.game.StateToMatrix());
-    std::vector<nn::DynamicMatrix> model_outputs;
-    network->Outputs(
-        {
-            network->outcome_output_index(),
-            network->policy_output_indices()[node.game.PolicyClassI()]
-        },
-        model_outputs);
-
-    // After creating the edges, we normalize the search probabilities because
-    // we don't expect the model to.
-    float policy_sum = 0.0f;
-    for (int i = 0; i < node.game.CurrentMovesN(); ++i) {
-      float policy = node.game.PolicyForMoveI(model_outputs[1], i);
-      policy_sum += policy;
-      edges.emplace_back(policy, node_i);
-      node.children_i.push_back(edges.size() - 1);
+    int total_saved_n = 0;
+    for (int tree_saved_n : saved_n) total_saved_n += tree_saved_n;
+    if (total_saved_n > 0) callbacks.SimulationsSaved(total_saved_n);
+    std::size_t total_collapsed_n = 0;
+    for (std::size_t n : collapsed_n) total_collapsed_n += n;
+    if (total_collapsed_n > 0) {
+      callbacks.ForcedMovesCollapsed(total_collapsed_n);
     }
-    for (auto& edge_i : node.children_i) {
-      edges[edge_i].search_prob /= policy_sum;
+    if (skip_search) {
+      callbacks.SearchSkipped(config_.simulations_n * config_.root_trees_n);
     }
+    callbacks.PostSearch(moves_n_);
+    return move_outcome;
+  }
 
-    // Since the model is trying to predict an outcome vector rotated s.t. the
-    // current player is in the first row, un-rotate the prediction.
-    for (int i = 0; i < Game::players_n(); ++i) {
-      node.predicted_outcome[
-          (i + node.game.CurrentPlayerI()) % Game::players_n()] = 
-              model_outputs[0](i, 0);
+  // Makes the move at move_i from the current position, where game is the
+  // position that resulted.
+  //
+  // In deterministic games every tree keeps the subtree below the move.
+  // Otherwise, the random events a tree drew when it expanded the move needn't
+  // match the ones in game. Those trees are started over unless the game can
+  // be hashed and the states turn out the same. Open-loop trees don't depend
+  // on the events drawn, and keep the subtree whenever game fits its root.
+  void Advance(int move_i, const Game& game) {
+    StopPondering();
+    if ((game_->State() == games::GameState::kOver) || (move_i < 0)
+        || (move_i >= game_->CurrentMovesN())) {
+      LOG(FATAL) << "Invalid move index: " << move_i;
     }
-
-    return node.predicted_outcome;
-  }
- 
- private:
-  static inline void RandomSeq(std::vector<std::size_t>& seq, 
-                               absl::BitGenRef bitgen) {
-    for (int i = 0; i < seq.size(); seq[i] = i, ++i);
-    std::shuffle(seq.begin(), seq.end(), bitgen);
+    for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+      if (roots_i_[tree_i] == kNoRoot) continue;
+      Tree& tree = *(trees_[tree_i]);
+      typename Tree::Index child_i = 
+          tree.child_i(tree.edge_i(roots_i_[tree_i], move_i));
+      bool reusable = (child_i != Tree::kBarren)
+          && (game.State() != games::GameState::kOver);
+      if (config_.open_loop) {
+        reusable = reusable && tree.Matches(child_i, game);
+      } else if constexpr (games::HashableGameType<Game>) {
+        reusable = reusable && (tree.game(child_i).Hash() == game.Hash());
+      } else if constexpr (!games::DeterministicGameType<Game>) {
+        reusable = false;
+      }
+      if (reusable) {
+        roots_i_[tree_i] = tree.Reroot(child_i);
+        if (config_.open_loop) tree.SetGame(roots_i_[tree_i], Game(game));
+      } else {
+        tree.clear();
+        roots_i_[tree_i] = kNoRoot;
+      }
+    }
+    game_ = std::make_unique<Game>(game);
+    ++moves_n_;
   }
 
-  static inline void DirichletNoise(std::vector<float>& noise, float alpha, 
-                                    absl::BitGenRef bitgen) {
-    // 1D, so \beta = 1.
-    std::gamma_distribution<float> gamma(alpha);
-    float sum = 0.0f;
-    for (auto& x : noise) {
-      x = gamma(bitgen);
-      sum += x;
+  // Keeps searching the current position on a background thread per tree
+  // until the session is next searched or advanced, or StopPondering is
+  // called. Meant for the time an opponent spends choosing their move: if a
+  // tree holds the move they make, Advance promotes it to the root with
+  // everything pondered below it, and its visits count towards the next
+  // Search, which then returns sooner. networks are as for Search, and mustn't
+  // be used elsewhere while pondering.
+  //
+  // If simulations_n isn't zero, each tree stops pondering after that many
+  // simulations. Otherwise, config.max_tree_nodes_n should bound the trees.
+  void Ponder(const std::vector<GameNetwork*>& networks,
+              int simulations_n = 0) {
+    StopPondering();
+    if (game_->State() == games::GameState::kOver) return;
+    if (networks.size()
+        < static_cast<std::size_t>(SearchNetworksN(config_))) {
+      LOG(FATAL) << "Need one network per search thread.";
+    }
+    // Pondering has no budget of its own to save, so it doesn't stop early.
+    Config ponder_config = config_;
+    ponder_config.early_stop = false;
+    for (int tree_i = 0; tree_i < config_.root_trees_n; ++tree_i) {
+      std::vector<GameNetwork*> tree_networks(
+          networks.begin() + tree_i * config_.search_threads_n,
+          networks.begin() + (tree_i + 1) * config_.search_threads_n);
+      ponder_threads_.emplace_back(
+          [this, tree_i, ponder_config, simulations_n,
+           tree_networks = std::move(tree_networks)] {
+            absl::BitGen bitgen;
+            Tree& tree = *(trees_[tree_i]);
+            if (roots_i_[tree_i] == kNoRoot) {
+              tree.clear();
+              roots_i_[tree_i] = tree.ExpandNode(Game(*game_), Tree::kBarren,
+                                                 tree_networks[0]);
+            }
+            int left_n = (simulations_n == 0)
+                ? std::numeric_limits<int>::max()
+                : simulations_n;
+            while ((left_n > 0) 
+                   && !stop_pondering_.load(std::memory_order_relaxed)) {
+              int visit_sum = tree.visit_sum(roots_i_[tree_i]);
+              roots_i_[tree_i] = tree.Search(
+                  roots_i_[tree_i], tree_networks, ponder_config,
+                  std::min(left_n, config_.simulations_n), bitgen);
+              int run_n = tree.visit_sum(roots_i_[tree_i]) - visit_sum;
+              // Nothing is left to search once the root is proven.
+              if (run_n <= 0) break;
+              left_n -= run_n;
+            }
+          });
     }
-    for (auto& x : noise) x /= sum;
   }
-};
 
-static inline int SamplePolicy(const std::unique_ptr<float[]>& prop, int size, 
-                               absl::BitGenRef bitgen) {
-  int move_index = 0;
+  // Stops pondering, if the session is, and waits for the searches to finish
+  // their rounds in flight.
+  void StopPondering() {
+    if (ponder_threads_.empty()) return;
+    stop_pondering_.store(true, std::memory_order_relaxed);
+    for (auto& thread : ponder_threads_) thread.join();
+    ponder_threads_.clear();
+    stop_pondering_.store(false, std::memory_order_relaxed);
+  }
 
-  float uniform = absl::Uniform(bitgen, 0.0f, 1.0f);
-  float total = 0.0f;
-  float prev_total = total;
-  for (; move_index < size; ++move_index) {
-    total += prop[move_index];
-    if ((uniform >= prev_total) && (uniform < total)) break;
-    prev_total = total;
+  // The position currently being searched.
+  const Game& game() const {
+    return *game_;
   }
-  // Handle round-off errors.
-  return (move_index == size) ? size - 1 : move_index;
-}
 
-}  // namespace internal
+ private:
+  using Tree = internal::GameTree<Game, GameNetwork>;
 
-template <games::AnyGameType Game>
-struct MoveOutcome {
-  // The outcome order-rotated s.t. the player who's move it is to make is in
-  // the first row.
-  //
-  // If not playing a full game, the value of this field is set by the outcome
-  // estimated at the root and is not rotated.
-  nn::Matrix<Game::players_n(), 1> outcome;
+  // Marks a tree that needs a new root before its next search.
+  static constexpr typename Tree::Index kNoRoot = Tree::kBarren;
 
-  // The visit proportions across move options at the searched game state.
-  nn::DynamicMatrix search_policy;
+  const Config config_;
+  // Games aren't necessarily assignable, so this is replaced on every move.
+  std::unique_ptr<Game> game_;
+  // The number of moves made with Advance.
+  int moves_n_;
+  absl::BitGen bitgen_;
 
-  // The index of the policy head of the games::GameNetwork that search_policy
-  // applies to.
-  std::size_t search_policy_class_i;
+  // Set to stop the searches of the pondering threads; see Tree::set_stop.
+  std::atomic<bool> stop_pondering_;
+  std::vector<std::thread> ponder_threads_;
 
-  // The network inputs that should yield outcome and search_policy.
-  std::vector<nn::DynamicMatrix> state_inputs;
+  // Parallel arrays, indexed by tree.
+  std::vector<std::unique_ptr<Tree>> trees_;
+  std::vector<typename Tree::Index> roots_i_;
 };
 
-struct Config {
-  // The total number of MCTS simulations to perform per-move.
-  //
-  // AlphaZero uses 800.
-  int simulations_n;
-
-  // If true, the game is played to completion from the provided game state.
-  // Otherwise, only the result of searching a single move is returned.
-  bool full_play;
+// The storage of a search tree. Passing the same tree to successive SelfPlay
+// calls lets each game reuse the memory of the last.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork>
+using SearchTree = internal::GameTree<Game, GameNetwork>;
 
-  // The alpha value of Dirichlet noise added to the root search policy. Noise
-  // is generated at every visit to the root.
-  //
-  // AlphaZero uses 0.3 for chess.
-  float root_noise_alpha;
+namespace internal {
 
-  // The amount interpolated between the predicted root policy and root noise.
-  //
-  // AlphaZero uses 0.25.
-  float root_noise_lerp;
+// The course of one full self-play game in tree apart from its searches and
+// the evaluations of new roots, which SelfPlay and SelfPlayConcurrently run in
+// their own ways. For each move, BeginMove is called, the root is searched as
+// it says, and then EndMove makes the move.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+class SelfPlayGame {
+ public:
+  using Tree = GameTree<Game, GameNetwork>;
+  using Index = typename Tree::Index;
 
-  // One-hot policy breakover threshold: the number of moves after which the
-  // search policies returned from self-play are just one-hot of the maximum
-  // valued move. If !full_play, the root search policy is never converted to
-  // one-hot.
-  //
-  // AlphaZero uses 30.
-  int one_hot_breakover_moves_n;
+  SelfPlayGame(const SelfPlayGame&) = delete;
+  SelfPlayGame& operator=(const SelfPlayGame&) = delete;
 
-  // A multiplier on the upper-confidence-bound that encourages exploration when
-  // higher.
-  float exploration_scale;
-};
+  SelfPlayGame(const Config& config, Tree& tree,
+               ReplicaCallbacks<Callbacks>& callbacks, MoveSink<Game>& sink,
+               int game_i) :
+      config_(config), fast_config_(config), tree_(tree),
+      callbacks_(callbacks), sink_(sink), game_i_(game_i),
+      opening_(nullptr), full_search_(false), simulations_n_(0),
+      collapsed_n_(0), total_moves_(0), carried_n_(0),
+      resigned_(false), resigning_player_i_(-1) {
+    // Fast searches only serve to pick a move, so they skip the root noise.
+    fast_config_.root_noise_lerp = 0.0f;
+    below_resign_n_.fill(0);
+  }
 
-// See MoveOutcome for the return values of this function.
-template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
-          CallbacksType Callbacks>
-std::vector<MoveOutcome<Game>> SelfPlay(
-    const Config& config, const Game& game, GameNetwork* network, 
-    ReplicaCallbacks<Callbacks>& callbacks) {
-  callbacks.PreGame();
-  if (game.State() == games::GameState::kOver) {
-    LOG(FATAL) << "Self play cannot begin from a terminal state.";
+  // Whether the game is over at root_i, by its own rules or by resignation.
+  bool Over(Index root_i) const {
+    return resigned_
+        || (tree_.game(root_i).State() != games::GameState::kOngoing);
   }
-  internal::GameTree<Game, GameNetwork> tree;
-  (void)tree.ExpandNode(Game(game), -1, network);
-  std::size_t root_i = 0;
-  internal::TreeNode<Game>* root = &(tree.nodes[root_i]);
 
-  // These are parallel arrays.
-  // 
-  // We build out the results and current_player_i rows during self-play, and
-  // when a winner is called, fill in the results outcome fields rotated to 
-  // respect the current_player_i for that row.
-  std::vector<MoveOutcome<Game>> results;
-  std::vector<int> current_player_i;
+  // The random stream of the game, which its searches should use too.
+  absl::BitGenRef bitgen() {
+    return bitgen_;
+  }
 
-  absl::BitGen bitgen;
-  int total_moves = 0;
-  while (root->game.State() == games::GameState::kOngoing) {
+  // Decides how the move at root_i is to be searched. Returns the config to
+  // search it with, and sets simulations_n to the number of simulations,
+  // which is 0 if the search is to be skipped.
+  const Config& BeginMove(Index root_i, int& simulations_n) {
     // To make a move, we first grow the tree a bunch from this position.
-    callbacks.PreSearch();
-    for (int sim_i = 0; sim_i < config.simulations_n; ++sim_i) {
-      tree.Search(root, network, config.exploration_scale,
-          config.root_noise_alpha, config.root_noise_lerp, bitgen);
-      // The vector backing this pointer can change in Search.
-      root = &(tree.nodes[root_i]);
+    callbacks_.PreSearch();
+    opening_ = FindOpening(root_i);
+    full_search_ = (opening_ != nullptr)
+        || (config_.full_search_fraction >= 1.0f)
+        || absl::Bernoulli(bitgen_, config_.full_search_fraction);
+    simulations_n_ = full_search_
+        ? config_.simulations_n + carried_n_
+        : config_.fast_simulations_n;
+    if (config_.skip_forced_moves && (tree_.moves_n(root_i) == 1)) {
+      callbacks_.SearchSkipped(simulations_n_);
+      simulations_n_ = 0;
+    } else if (opening_ != nullptr) {
+      callbacks_.OpeningCacheHit(simulations_n_);
+      simulations_n_ = 0;
+    }
+    collapsed_n_ = tree_.collapsed_n();
+    simulations_n = simulations_n_;
+    return full_search_ ? config_ : fast_config_;
+  }
+
+  // Records the move searched at root_i and makes it. If its state is in the
+  // tree, it becomes the root and root_i is updated. Otherwise the tree is
+  // cleared and the state is returned, to be expanded as the new root. If the
+  // player to move resigns instead, no move is made and the game is Over.
+  std::optional<Game> EndMove(Index& root_i) {
+    const int moves_n = tree_.moves_n(root_i);
+    int saved_n = (simulations_n_ > 0) ? tree_.early_stopped_n() : 0;
+    if (saved_n > 0) callbacks_.SimulationsSaved(saved_n);
+    if (full_search_ && config_.early_stop_carry_over) {
+      carried_n_ = std::min(saved_n, config_.simulations_n);
     }
-    const int moves_n = root->children_i.size();
-    callbacks.PostSearch(total_moves);
+    std::size_t collapsed_n = tree_.collapsed_n() - collapsed_n_;
+    if (collapsed_n > 0) callbacks_.ForcedMovesCollapsed(collapsed_n);
+    callbacks_.PostSearch(total_moves_);
 
-    // Next, we take the search proportions at the root and create a policy
-    // vector from them.
+    // Next, we take the search proportions at the root (or those cached for
+    // it) and create a policy vector from them.
     auto search_policy = std::unique_ptr<float[]>(new float[moves_n]);
     float max_search_policy = 0.0f;
     for (int move_i = 0; move_i < moves_n; ++move_i) {
       // Since we've been tracking node visit sums, this will come out
       // normalized.
-      search_policy[move_i] = 
-          static_cast<float>(tree.edges[root->children_i[move_i]].visits_n) 
-              / static_cast<float>(root->visit_sum);
+      search_policy[move_i] = (opening_ != nullptr)
+          ? opening_->policy[move_i]
+          : static_cast<float>(tree_.visits_n(tree_.edge_i(root_i, move_i))) 
+              / static_cast<float>(tree_.visit_sum(root_i));
       if (search_policy[move_i] > max_search_policy) {
         max_search_policy = search_policy[move_i];
       }
     }
-    if (config.full_play && (total_moves >= config.one_hot_breakover_moves_n)) {
+    // With a Gumbel search or a cached opening, the move is decided apart
+    // from the policy rather than sampled from it.
+    int decided_move_i = -1;
+    if (moves_n == 1) {
+      // The only move may not have been searched at all.
+      search_policy[0] = 1.0f;
+    } else if (opening_ != nullptr) {
+      // The root wasn't searched, so the cached policy stands in for it.
+      if (total_moves_ < config_.one_hot_breakover_moves_n) {
+        decided_move_i = NoisyOpeningMoveI(search_policy, moves_n);
+      } else {
+        for (int move_i = 0; move_i < moves_n; ++move_i) {
+          search_policy[move_i] = (search_policy[move_i] == max_search_policy)
+              ? 1.0f
+              : 0.0f;
+        }
+      }
+    } else if (config_.solve && tree_.proven(root_i)) {
+      // Play (and learn) the move that achieves the proven outcome.
+      int proven_move_i = tree_.ProvenMoveI(root_i);
+      for (int move_i = 0; move_i < moves_n; ++move_i) {
+        search_policy[move_i] = (move_i == proven_move_i) ? 1.0f : 0.0f;
+      }
+    } else if (config_.gumbel_considered_n > 0) {
+      tree_.GumbelPolicy(root_i, config_, search_policy.get());
+      decided_move_i = tree_.GumbelMoveI(root_i, config_);
+    } else if (total_moves_ >= config_.one_hot_breakover_moves_n) {
       for (int move_i = 0; move_i < moves_n; ++move_i) {
         search_policy[move_i] = (search_policy[move_i] == max_search_policy)
             ? 1.0f
@@ -386,56 +2882,482 @@ std::vector<MoveOutcome<Game>> SelfPlay(
       }
     }
 
-    // Next, copy the vectorized stats into the output.
-    MoveOutcome<Game> move_outcome;
-    move_outcome.search_policy_class_i = root->game.PolicyClassI();
-    move_outcome.state_inputs = root->game.StateToMatrix();
-    move_outcome.search_policy = root->game.PolicyMask();
-    int move_i = 0;
-    for (int policy_vec_i = 0; policy_vec_i < move_outcome.search_policy.rows();
-        ++policy_vec_i) {
-      if (move_outcome.search_policy(policy_vec_i, 0) == 0.0f) continue;
-      move_outcome.search_policy(policy_vec_i, 0) = search_policy[move_i++];
+    // Next, pass the vectorized stats on to the sink, to be scored once the
+    // game is over. Fast searches are too shallow to make good policy
+    // targets, so they aren't recorded.
+    if (full_search_) {
+      MoveOutcome<Game> move = PolicyToMoveOutcome(tree_.game(root_i),
+                                                   search_policy);
+      move.outcome.setZero();
+      sink_.AddMove(game_i_, tree_.game(root_i).CurrentPlayerI(),
+                    std::move(move));
     }
-    results.push_back(std::move(move_outcome));
-    current_player_i.push_back(root->game.CurrentPlayerI());
+    if (Resigns(root_i)) return std::nullopt;
+
+    // Next, and the last step in self-play, we sample from the search policy
+    int move_index = (decided_move_i != -1)
+        ? decided_move_i
+        : SamplePolicy(search_policy, moves_n, bitgen_);
+    ++total_moves_;
 
-    // If we're just looking at this one move, we can leave.
-    if (!config.full_play) {
-      // Copy the outcome (not rotated) predicted at the root into the results.
-      for (std::size_t player_i = 0; player_i < Game::players_n(); ++player_i) {
-        results[0].outcome(player_i, 0) = root->predicted_outcome[player_i];
+    // Everything outside of the subtree below the move is thrown away.
+    Index child_i = tree_.child_i(tree_.edge_i(root_i, move_index));
+    std::optional<Game> next_game;
+    if (config_.open_loop || (child_i == Tree::kBarren)) {
+      // Open-loop nodes don't keep their games, and the move's chance events
+      // are drawn now rather than taken from the tree. Otherwise a barren
+      // child is only possible if round-off picked a move that was never
+      // visited, or a Gumbel search ran out of simulations before visiting its
+      // move.
+      next_game.emplace(tree_.game(root_i));
+      if constexpr (games::DeterministicGameType<Game>) {
+        next_game->MakeMove(move_index);
+      } else {
+        next_game->MakeMove(move_index, bitgen_);
+      }
+      if (!config_.open_loop || (child_i == Tree::kBarren)
+          || !tree_.Matches(child_i, *next_game)) {
+        tree_.clear();
+        return next_game;
       }
-      callbacks.PostGame(1);
-      return results;
     }
-    // Next, and the last step in self-play, we sample from the search policy
-    int move_index = internal::SamplePolicy(search_policy, 
-                                            root->children_i.size(), bitgen);
+    root_i = tree_.Reroot(child_i);
+    if (next_game) tree_.SetGame(root_i, std::move(*next_game));
+    return std::nullopt;
+  }
+
+  // Scores the game, which ended at root_i, for the sink.
+  void Finish(Index root_i) {
+    auto outcome = resigned_ 
+        ? AdjudicatedOutcome(root_i) 
+        : tree_.game(root_i).Outcome();
+    if (resigned_) {
+      callbacks_.GameResigned();
+    } else if (resigning_player_i_ != -1) {
+      // The game would have been resigned. It was a mistake if the player who
+      // would have resigned did better than the nothing resigning scores.
+      callbacks_.ResignationPlayedOut(outcome[resigning_player_i_] > 0.0f);
+    }
+    sink_.EndGame(game_i_, outcome);
+    callbacks_.PostGame(total_moves_);
+  }
+
+ private:
+  const Config& config_;
+  Config fast_config_;
+  Tree& tree_;
+  ReplicaCallbacks<Callbacks>& callbacks_;
+  MoveSink<Game>& sink_;
+  const int game_i_;
+  absl::BitGen bitgen_;
+
+  // The cached result the current move is played from, if any.
+  const OpeningCache::Entry* opening_;
+
+  // How the current move is being searched, and the tree's collapsed_n
+  // before.
+  bool full_search_;
+  int simulations_n_;
+  std::size_t collapsed_n_;
+
+  int total_moves_;
+  // Simulations saved by stopping early that carry over to the next move.
+  int carried_n_;
+
+  // Whether the game ended by resignation, and the player who resigned (or
+  // first would have, if the game is being played out), or -1.
+  bool resigned_;
+  int resigning_player_i_;
+  // The number of each player's latest moves in a row whose value was below
+  // config_.resign_threshold.
+  std::array<int, Game::players_n()> below_resign_n_;
+
+  // The cached result of the position at root_i, if any; see
+  // Config::opening_cache.
+  const OpeningCache::Entry* FindOpening(Index root_i) const {
+    const OpeningCache* cache = config_.opening_cache;
+    if ((cache == nullptr) || (total_moves_ >= cache->plies_n())) {
+      return nullptr;
+    }
+    return cache->Find(OpeningCache::Key(tree_.game(root_i)),
+                       tree_.moves_n(root_i), config_.opening_checkpoint);
+  }
+
+  // Samples a move from the cached policy with fresh root noise interpolated
+  // in, standing in for the noise a search of the move would have had.
+  int NoisyOpeningMoveI(const std::unique_ptr<float[]>& policy, int moves_n) {
+    if (config_.root_noise_lerp <= 0.0f) {
+      return SamplePolicy(policy, moves_n, bitgen_);
+    }
+    std::vector<float> noise(moves_n);
+    DirichletNoise(noise, config_.root_noise_alpha, bitgen_);
+    auto noisy_policy = std::unique_ptr<float[]>(new float[moves_n]);
+    for (int move_i = 0; move_i < moves_n; ++move_i) {
+      noisy_policy[move_i] = (noise[move_i] - policy[move_i]) 
+          * config_.root_noise_lerp + policy[move_i];
+    }
+    return SamplePolicy(noisy_policy, moves_n, bitgen_);
+  }
 
-    // Setting parent_i to -1 ensures future searches don't propagate anything
-    // past the new root and that noise is added where appropriate.
-    root_i = tree.edges[root->children_i[move_index]].child_i;
-    root = &(tree.nodes[root_i]);
-    root->parent_i = -1;
+  // Decides whether the player to move at root_i resigns, per
+  // Config::resign_threshold.
+  bool Resigns(Index root_i) {
+    int visit_sum = tree_.visit_sum(root_i);
+    if ((config_.resign_threshold == 0.0f) || (visit_sum == 0)) return false;
+    float value = 0.0f;
+    for (int move_i = 0; move_i < tree_.moves_n(root_i); ++move_i) {
+      Index edge_i = tree_.edge_i(root_i, move_i);
+      value += tree_.outcome(edge_i) * tree_.visits_n(edge_i);
+    }
+    value /= static_cast<float>(visit_sum);
 
-    ++total_moves;
+    int player_i = tree_.game(root_i).CurrentPlayerI();
+    if (value >= config_.resign_threshold) {
+      below_resign_n_[player_i] = 0;
+      return false;
+    }
+    if ((++below_resign_n_[player_i] < config_.resign_moves_n) 
+        || (resigning_player_i_ != -1)) {
+      return false;
+    }
+    resigning_player_i_ = player_i;
+    resigned_ = (config_.resign_playout_fraction <= 0.0f)
+        || !absl::Bernoulli(bitgen_, config_.resign_playout_fraction);
+    return resigned_;
   }
 
-  // Finally, score the game, and copy the rotated outcome into the result rows. 
-  auto outcome = root->game.Outcome();
-  for (int i = 0; i < results.size(); ++i) {
+  // The outcome of a game resigned at root_i.
+  std::array<float, Game::players_n()> AdjudicatedOutcome(Index root_i) const {
+    std::array<float, Game::players_n()> outcome = 
+        tree_.predicted_outcome(root_i);
+    outcome[resigning_player_i_] = 0.0f;
+    float outcome_sum = 0.0f;
+    for (float player_outcome : outcome) outcome_sum += player_outcome;
     for (int player_i = 0; player_i < Game::players_n(); ++player_i) {
-      results[i].outcome(
-          (player_i + current_player_i[i]) % Game::players_n(), 0) = 
-              outcome[player_i];
+      if (player_i == resigning_player_i_) continue;
+      outcome[player_i] = (outcome_sum > 0.0f)
+          ? outcome[player_i] / outcome_sum
+          : 1.0f / static_cast<float>(Game::players_n() - 1);
+    }
+    return outcome;
+  }
+};
+
+// Plays out a full game in tree, suspending whenever a search round or a new
+// root needs evaluating. The moves recorded go to sink as game game_i.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+typename GameTree<Game, GameNetwork>::SearchTask PlaySelfPlayGame(
+    const Config& config, const Game& game, GameTree<Game, GameNetwork>& tree,
+    ReplicaCallbacks<Callbacks>& callbacks, MoveSink<Game>& sink,
+    int game_i) {
+  using Tree = GameTree<Game, GameNetwork>;
+  using Request = typename Tree::EvaluationRequest;
+  callbacks.PreGame();
+  tree.clear();
+  tree.set_evaluation_cache_n(config.evaluation_cache_n);
+  SelfPlayGame<Game, GameNetwork, Callbacks> play(config, tree, callbacks,
+                                                  sink, game_i);
+
+  // Holds the state to expand as the next root, if any.
+  std::vector<Game> root_games;
+  std::vector<Evaluation<Game>> root_evaluations;
+  root_games.push_back(Game(game));
+  typename Tree::Index root_i = Tree::kBarren;
+  for (;;) {
+    if (!root_games.empty()) {
+      const Evaluation<Game>* evaluation = nullptr;
+      if (root_games[0].State() == games::GameState::kOngoing) {
+        co_await Request{&tree, &root_games, &root_evaluations};
+        evaluation = &(root_evaluations[0]);
+      }
+      root_i = tree.ExpandNode(std::move(root_games[0]), Tree::kBarren,
+                               evaluation);
+      root_games.clear();
+    }
+    if (play.Over(root_i)) break;
+
+    int simulations_n;
+    const Config& move_config = play.BeginMove(root_i, simulations_n);
+    if (simulations_n > 0) {
+      auto search = tree.SearchSuspending(root_i, move_config, simulations_n,
+                                          play.bitgen());
+      while (const Request* request = search.Resume()) co_await *request;
+    }
+    if (std::optional<Game> next_game = play.EndMove(root_i)) {
+      root_games.push_back(std::move(*next_game));
+    }
+  }
+  play.Finish(root_i);
+}
+
+// Fails unless self-play can start from game with config and networks_n
+// networks.
+template <games::AnyGameType Game>
+void CheckSelfPlay(const Config& config, const Game& game,
+                   std::size_t networks_n) {
+  if (game.State() == games::GameState::kOver) {
+    LOG(FATAL) << "Self play cannot begin from a terminal state.";
+  }
+  if ((config.search_threads_n < 1) || (config.root_trees_n < 1)
+      || (networks_n < static_cast<std::size_t>(SearchNetworksN(config)))) {
+    LOG(FATAL) << "Need one network per search thread.";
+  }
+  if ((config.full_search_fraction < 1.0f) 
+      && (config.fast_simulations_n < 1)) {
+    LOG(FATAL) << "Fast searches need at least one simulation.";
+  }
+}
+
+}  // namespace internal
+
+// Plays a full game as SelfPlay does, passing the moves recorded to sink as
+// game game_i while the game is played; see MoveSink. config.full_play must
+// be set.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+void SelfPlay(
+    const Config& config, const Game& game, 
+    const std::vector<GameNetwork*>& networks, 
+    SearchTree<Game, GameNetwork>& tree,
+    ReplicaCallbacks<Callbacks>& callbacks, MoveSink<Game>& sink,
+    int game_i = 0) {
+  callbacks.PreGame();
+  internal::CheckSelfPlay(config, game, networks.size());
+  if (!config.full_play) {
+    LOG(FATAL) << "Only full games are passed to a move sink.";
+  }
+
+  std::vector<GameNetwork*> search_networks(
+      networks.begin(), networks.begin() + config.search_threads_n);
+
+  using Tree = SearchTree<Game, GameNetwork>;
+  tree.clear();
+  tree.set_evaluation_cache_n(config.evaluation_cache_n);
+  typename Tree::Index root_i = tree.ExpandNode(Game(game), Tree::kBarren,
+                                                networks[0]);
+  internal::SelfPlayGame<Game, GameNetwork, Callbacks> play(
+      config, tree, callbacks, sink, game_i);
+  while (!play.Over(root_i)) {
+    int simulations_n;
+    const Config& move_config = play.BeginMove(root_i, simulations_n);
+    if (simulations_n > 0) {
+      root_i = tree.Search(root_i, search_networks, move_config, simulations_n,
+                           play.bitgen());
+    }
+    if (std::optional<Game> next_game = play.EndMove(root_i)) {
+      root_i = tree.ExpandNode(std::move(*next_game), Tree::kBarren, 
+                               networks[0]);
     }
   }
+  play.Finish(root_i);
+}
+
+// See MoveOutcome for the return values of this function.
+//
+// networks must hold at least SearchNetworksN(config) networks with the same
+// weights, one per search thread. Full games are played in tree, which is
+// cleared first. Otherwise the position is searched by a SearchSession that
+// evaluates as tree does, with its inference service if it has one and in its
+// evaluation cache, so searching a position again reuses what it evaluated.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+std::vector<MoveOutcome<Game>> SelfPlay(
+    const Config& config, const Game& game, 
+    const std::vector<GameNetwork*>& networks, 
+    SearchTree<Game, GameNetwork>& tree,
+    ReplicaCallbacks<Callbacks>& callbacks) {
+  if (config.full_play) {
+    MoveCollector<Game> collector;
+    SelfPlay(config, game, networks, tree, callbacks, collector);
+    return collector.TakeMoves();
+  }
 
-  callbacks.PostGame(results.size());
+  // If we're just looking at this one move, there's nothing to play out.
+  callbacks.PreGame();
+  internal::CheckSelfPlay(config, game, networks.size());
+  SearchSession<Game, GameNetwork> session(config, game);
+  // The networks may all be the service's.
+  session.set_inference_service(tree.inference_service());
+  session.set_evaluation_cache(tree.evaluation_cache());
+  std::vector<MoveOutcome<Game>> results;
+  results.push_back(session.Search(networks, callbacks));
+  callbacks.PostGame(1);
   return results;
 }
 
+// Plays games_n full games from game at once on the calling thread, one per
+// tree of trees (which are added as needed and cleared first), passing the
+// moves recorded to sink as they're made, with games numbered from 0.
+//
+// Each game runs as a coroutine that suspends wherever it needs the network.
+// Once every game is suspended, the states they're all waiting on are
+// evaluated together, in batched forward passes across the games (see
+// GameTree::EvaluateRequests), and the games resume. Search rounds are as in
+// SelfPlay with a single search thread.
+//
+// config.full_play must be set and config.search_threads_n must be 1. Gumbel
+// searches and config.search_time_limit aren't supported.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+void SelfPlayConcurrently(
+    const Config& config, const Game& game, int games_n, GameNetwork* network,
+    std::vector<std::unique_ptr<SearchTree<Game, GameNetwork>>>& trees,
+    ReplicaCallbacks<Callbacks>& callbacks, MoveSink<Game>& sink) {
+  internal::CheckSelfPlay(config, game, 1);
+  if (!config.full_play || (config.search_threads_n != 1)) {
+    LOG(FATAL) << "Concurrent self-play plays full games with one search "
+                  "thread.";
+  }
+
+  using Tree = SearchTree<Game, GameNetwork>;
+  using Request = typename Tree::EvaluationRequest;
+  while (trees.size() < static_cast<std::size_t>(games_n)) {
+    trees.push_back(std::make_unique<Tree>());
+  }
+  Config play_config = config;
+  play_config.leaf_batch_n = LeafBatchN(config, network);
+  std::vector<typename Tree::SearchTask> tasks;
+  std::vector<const Request*> requests;
+  for (int i = 0; i < games_n; ++i) {
+    tasks.push_back(internal::PlaySelfPlayGame(play_config, game, *(trees[i]),
+                                               callbacks, sink, i));
+    requests.push_back(tasks.back().Resume());
+  }
+  for (;;) {
+    auto done = [](const Request* request) { return request == nullptr; };
+    if (std::all_of(requests.begin(), requests.end(), done)) break;
+    Tree::EvaluateRequests(requests, network);
+    for (int i = 0; i < games_n; ++i) {
+      if (requests[i] != nullptr) requests[i] = tasks[i].Resume();
+    }
+  }
+}
+
+// As above, but returns the moves recorded by each game, one game after
+// another.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+std::vector<MoveOutcome<Game>> SelfPlayConcurrently(
+    const Config& config, const Game& game, int games_n, GameNetwork* network,
+    std::vector<std::unique_ptr<SearchTree<Game, GameNetwork>>>& trees,
+    ReplicaCallbacks<Callbacks>& callbacks) {
+  MoveCollector<Game> collector;
+  SelfPlayConcurrently(config, game, games_n, network, trees, callbacks,
+                       collector);
+  return collector.TakeMoves();
+}
+
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+std::vector<MoveOutcome<Game>> SelfPlay(
+    const Config& config, const Game& game, 
+    const std::vector<GameNetwork*>& networks, 
+    ReplicaCallbacks<Callbacks>& callbacks) {
+  SearchTree<Game, GameNetwork> tree;
+  return SelfPlay(config, game, networks, tree, callbacks);
+}
+
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork, 
+          CallbacksType Callbacks>
+std::vector<MoveOutcome<Game>> SelfPlay(
+    const Config& config, const Game& game, GameNetwork* network, 
+    ReplicaCallbacks<Callbacks>& callbacks) {
+  return SelfPlay(config, game, std::vector<GameNetwork*>{network}, callbacks);
+}
+
+// Fills cache, which is cleared first and tagged with checkpoint, with the
+// positions games_n self-play games from Game() are expected to reach at least
+// min_games_n times in their first plies_n moves; see Config::opening_cache.
+// Games dealt at random each start from a fresh deal, as in RLPlayer's
+// self-play.
+//
+// The games are followed a ply at a time: every position reached often enough
+// is searched as a SearchSession would with config and networks, and its
+// games are split among its moves by sampling the policy found, and among the
+// results of each move by making it. Games reaching positions with the same
+// OpeningCache::Key are counted together, and the first of them stands for
+// the rest. Positions below min_games_n aren't searched, and neither are any
+// of the positions after them.
+template <games::AnyGameType Game, games::GameNetworkType GameNetwork,
+          CallbacksType Callbacks>
+void BuildOpeningCache(
+    const Config& config, int plies_n, int games_n, int min_games_n,
+    uint64_t checkpoint, const std::vector<GameNetwork*>& networks,
+    ReplicaCallbacks<Callbacks>& callbacks, OpeningCache& cache) {
+  if (games_n < 1) {
+    LOG(FATAL) << "Need at least one game to build an opening cache from.";
+  }
+  cache.clear();
+  cache.set_checkpoint(checkpoint);
+  cache.set_plies_n(plies_n);
+
+  // The positions of the current ply, their keys, and how many games reach
+  // each.
+  struct Position {
+    Game game;
+    uint64_t key;
+    int games_n;
+  };
+  std::vector<Position> positions;
+  absl::flat_hash_map<uint64_t, std::size_t> positions_i;
+  // Counts one more game reaching game in positions.
+  auto add_game = [&](Game&& game) {
+        uint64_t key = OpeningCache::Key(game);
+        auto [iter, is_new] = positions_i.insert({key, positions.size()});
+        if (is_new) {
+          positions.push_back({std::move(game), key, 1});
+        } else {
+          ++(positions[iter->second].games_n);
+        }
+      };
+  for (int game_i = 0; game_i < games_n; ++game_i) add_game(Game());
+
+  absl::BitGen bitgen;
+  for (int ply_i = 0; (ply_i < plies_n) && !positions.empty(); ++ply_i) {
+    std::vector<Position> ply_positions = std::move(positions);
+    positions.clear();
+    positions_i.clear();
+    for (const Position& position : ply_positions) {
+      if ((position.games_n < min_games_n)
+          || (position.game.State() != games::GameState::kOngoing)) {
+        continue;
+      }
+      const int moves_n = position.game.CurrentMovesN();
+      // A position may be reached at more than one ply.
+      const OpeningCache::Entry* entry =
+          cache.Find(position.key, moves_n, checkpoint);
+      if (entry == nullptr) {
+        SearchSession<Game, GameNetwork> session(config, position.game);
+        MoveOutcome<Game> move = session.Search(networks, callbacks);
+        OpeningCache::Entry new_entry;
+        for (int move_i = 0; move_i < moves_n; ++move_i) {
+          new_entry.policy.push_back(
+              position.game.PolicyForMoveI(move.search_policy, move_i));
+        }
+        for (int player_i = 0; player_i < Game::players_n(); ++player_i) {
+          new_entry.outcome.push_back(move.outcome(player_i, 0));
+        }
+        cache.Add(position.key, std::move(new_entry));
+        entry = cache.Find(position.key, moves_n, checkpoint);
+      }
+
+      auto policy = std::unique_ptr<float[]>(new float[moves_n]);
+      std::copy(entry->policy.begin(), entry->policy.end(), policy.get());
+      for (int game_i = 0; game_i < position.games_n; ++game_i) {
+        Game next_game(position.game);
+        int move_i = internal::SamplePolicy(policy, moves_n, bitgen);
+        if constexpr (games::DeterministicGameType<Game>) {
+          next_game.MakeMove(move_i);
+        } else {
+          next_game.MakeMove(move_i, bitgen);
+        }
+        add_game(std::move(next_game));
+      }
+    }
+  }
+}
+
 }  // namespace self_play
 }  // namespace mcts
 }  // namespace azah
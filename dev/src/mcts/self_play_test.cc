@@ -0,0 +1,269 @@
+#include "self_play.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+#include "../games/game.h"
+#include "../games/ignoble/ignoble4.h"
+#include "../games/ignoble/ignoble4_network.h"
+#include "../games/mancala/mancala.h"
+#include "../games/mancala/mancala_network.h"
+#include "../games/tictactoe/tictactoe.h"
+#include "../games/tictactoe/tictactoe_network.h"
+#include "../nn/data_types.h"
+#include "absl/random/random.h"
+#include "callbacks.h"
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace self_play {
+namespace {
+
+template <games::AnyGameType GameT, games::GameNetworkType GameNetworkT>
+struct GamePair {
+  using Game = GameT;
+  using GameNetwork = GameNetworkT;
+};
+
+using GamePairs = ::testing::Types<
+    GamePair<games::tictactoe::Tictactoe, games::tictactoe::TictactoeNetwork>,
+    GamePair<games::mancala::Mancala, games::mancala::MancalaNetwork>,
+    GamePair<games::ignoble::Ignoble4, games::ignoble::Ignoble4Network>>;
+
+// Returns the ongoing states of random games, states_n of them.
+template <games::AnyGameType Game>
+std::vector<Game> RandomStates(std::size_t states_n, absl::BitGenRef bitgen) {
+  std::vector<Game> states;
+  while (states.size() < states_n) {
+    Game game;
+    while ((states.size() < states_n)
+           && (game.State() == games::GameState::kOngoing)) {
+      states.push_back(game);
+      int move_i = absl::Uniform(bitgen, 0, game.CurrentMovesN());
+      if constexpr (games::DeterministicGameType<Game>) {
+        game.MakeMove(move_i);
+      } else {
+        game.MakeMove(move_i, bitgen);
+      }
+    }
+  }
+  return states;
+}
+
+template <typename T>
+class SelfPlayTest : public ::testing::Test {};
+TYPED_TEST_SUITE(SelfPlayTest, GamePairs);
+
+TYPED_TEST(SelfPlayTest, BatchedEvaluationMatchesSingle) {
+  using Game = typename TypeParam::Game;
+  using GameNetwork = typename TypeParam::GameNetwork;
+  using Tree = SearchTree<Game, GameNetwork>;
+
+  absl::BitGen bitgen;
+  GameNetwork network;
+  ASSERT_NE(network.Batched(), nullptr);
+  // A full batch, then stragglers evaluated one at a time.
+  std::size_t batch_n = network.Batched()->batch_n();
+  std::vector<Game> states = RandomStates<Game>(2 * batch_n - 1, bitgen);
+
+  std::vector<internal::Evaluation<Game>> batched(states.size());
+  Tree::EvaluateBatchWithNetwork(&network, states, batched);
+  for (std::size_t i = 0; i < states.size(); ++i) {
+    internal::Evaluation<Game> single;
+    Tree::EvaluateWithNetwork(states[i], &network, single);
+    ASSERT_EQ(batched[i].policy.size(), single.policy.size());
+    for (std::size_t j = 0; j < single.policy.size(); ++j) {
+      EXPECT_NEAR(batched[i].policy[j], single.policy[j], 1e-4f);
+    }
+    for (int j = 0; j < Game::players_n(); ++j) {
+      EXPECT_NEAR(batched[i].outcome[j], single.outcome[j], 1e-4f);
+    }
+  }
+}
+
+TYPED_TEST(SelfPlayTest, BatchedNetworkFollowsWeights) {
+  using GameNetwork = typename TypeParam::GameNetwork;
+
+  GameNetwork network;
+  games::GameNetwork* batched = network.Batched();
+  ASSERT_NE(batched, nullptr);
+  EXPECT_EQ(batched->version(), network.version());
+
+  GameNetwork other;
+  network.CopyVariables(other);
+  EXPECT_EQ(network.Batched(), batched);
+  EXPECT_EQ(batched->version(), other.version());
+  EXPECT_EQ(batched->Batched(), nullptr);
+}
+
+TYPED_TEST(SelfPlayTest, SharedCacheMissesOnceWeightsChange) {
+  using Game = typename TypeParam::Game;
+  using GameNetwork = typename TypeParam::GameNetwork;
+  using Tree = SearchTree<Game, GameNetwork>;
+  if constexpr (!games::HashableGameType<Game>) {
+    GTEST_SKIP() << "Only hashable games cache evaluations.";
+  } else {
+    GameNetwork network;
+    typename Tree::EvaluationCache cache;
+    Tree tree_a;
+    Tree tree_b;
+    tree_a.set_evaluation_cache(&cache);
+    tree_b.set_evaluation_cache(&cache);
+    tree_a.set_evaluation_cache_n(1024);
+    ASSERT_TRUE(cache.enabled());
+
+    Game game;
+    internal::Evaluation<Game> evaluation;
+    tree_a.Evaluate(game, &network, evaluation);
+    EXPECT_TRUE(cache.Find(game.Hash(), network.version(), evaluation));
+
+    // Variables that can be written through count as changed.
+    std::vector<nn::DynamicMatrixRef> variables;
+    network.GetVariables({}, variables);
+    EXPECT_FALSE(cache.Find(game.Hash(), network.version(), evaluation));
+    tree_b.Evaluate(game, &network, evaluation);
+    EXPECT_TRUE(cache.Find(game.Hash(), network.version(), evaluation));
+
+    std::vector<nn::DynamicMatrix> values(variables.begin(), variables.end());
+    network.SetVariables({}, values);
+    EXPECT_FALSE(cache.Find(game.Hash(), network.version(), evaluation));
+  }
+}
+
+TEST(SelfPlayPositionTest, SearchingAgainReusesEvaluations) {
+  using Game = games::tictactoe::Tictactoe;
+  using GameNetwork = games::tictactoe::TictactoeNetwork;
+
+  // Few enough states follow this position that one search evaluates them
+  // all, whichever way its ties are broken.
+  Game game;
+  for (int i = 0; i < 6; ++i) game.MakeMove(0);
+  ASSERT_EQ(game.State(), games::GameState::kOngoing);
+
+  Config config = {
+      .simulations_n = 50,
+      .full_play = false,
+      .root_noise_alpha = 0.3f,
+      .root_noise_lerp = 0.0f,
+      .one_hot_breakover_moves_n = 0,
+      .exploration_scale = 1.0f,
+      .evaluation_cache_n = 1024};
+  GameNetwork network;
+  std::vector<GameNetwork*> networks = {&network};
+  SearchTree<Game, GameNetwork> tree;
+  CallbacksBase callbacks;
+  ReplicaCallbacks<CallbacksBase> replica_callbacks(0, callbacks);
+  SelfPlay(config, game, networks, tree, replica_callbacks);
+  uint32_t cycle = network.cycle();
+  ASSERT_NE(cycle, 0);
+
+  SelfPlay(config, game, networks, tree, replica_callbacks);
+  EXPECT_EQ(network.cycle(), cycle);
+}
+
+// Counts the simulations reported saved.
+class SavedCallbacks : public CallbacksBase {
+ public:
+  void SimulationsSaved(int replica_i, std::size_t simulations_n) override {
+    saved_n += simulations_n;
+  }
+
+  std::size_t saved_n = 0;
+};
+
+TEST(SelfPlayPositionTest, OnlyEarlyStopsSaveSimulations) {
+  using Game = games::tictactoe::Tictactoe;
+  using GameNetwork = games::tictactoe::TictactoeNetwork;
+
+  Config config = {
+      .simulations_n = 1000000,
+      .full_play = false,
+      .root_noise_alpha = 0.3f,
+      .root_noise_lerp = 0.25f,
+      .one_hot_breakover_moves_n = 0,
+      .exploration_scale = 1.0f,
+      .search_time_limit = std::chrono::microseconds(1000)};
+  GameNetwork network;
+  std::vector<GameNetwork*> networks = {&network};
+  SavedCallbacks callbacks;
+  ReplicaCallbacks<SavedCallbacks> replica_callbacks(0, callbacks);
+  SelfPlay(config, Game(), networks, replica_callbacks);
+  EXPECT_EQ(callbacks.saved_n, 0);
+
+  // Any lead is secure without a margin.
+  config.early_stop = true;
+  config.early_stop_margin = 0.0f;
+  SelfPlay(config, Game(), networks, replica_callbacks);
+  EXPECT_GT(callbacks.saved_n, 0);
+}
+
+TEST(SearchTreeTest, PruneCountsEveryParentOfTranspositions) {
+  using Game = games::tictactoe::Tictactoe;
+  using GameNetwork = games::tictactoe::TictactoeNetwork;
+  using Tree = SearchTree<Game, GameNetwork>;
+
+  Config config = {
+      .simulations_n = 3000,
+      .full_play = false,
+      .root_noise_alpha = 0.3f,
+      .root_noise_lerp = 0.25f,
+      .one_hot_breakover_moves_n = 0,
+      .exploration_scale = 1.0f};
+  absl::BitGen bitgen;
+  GameNetwork network;
+  std::vector<GameNetwork*> networks = {&network};
+  Tree tree;
+  Tree::Index root_i = tree.ExpandNode(Game(), Tree::kBarren, &network);
+  root_i = tree.Search(root_i, networks, config, config.simulations_n, bitgen);
+  for (std::size_t nodes_n : {400, 100, 20}) {
+    root_i = tree.Prune(root_i, nodes_n);
+    // The root is kept besides.
+    EXPECT_LE(tree.nodes_n(), nodes_n + 1);
+  }
+}
+
+TEST(SetMoveOutcomeTest, PutsMoverFirst) {
+  using Game = games::ignoble::Ignoble4;
+  std::array<float, Game::players_n()> outcome = {0.1f, 0.2f, 0.3f, 0.4f};
+  for (int player_i = 0; player_i < Game::players_n(); ++player_i) {
+    MoveOutcome<Game> move;
+    SetMoveOutcome<Game>(outcome, player_i, move);
+    for (int i = 0; i < Game::players_n(); ++i) {
+      EXPECT_EQ(move.outcome(i, 0),
+                outcome[(player_i + i) % Game::players_n()]);
+    }
+  }
+}
+
+TEST(SetMoveOutcomeTest, MatchesNetworkRotation) {
+  using Game = games::ignoble::Ignoble4;
+  using GameNetwork = games::ignoble::Ignoble4Network;
+  absl::BitGen bitgen;
+  GameNetwork network;
+  for (const Game& game : RandomStates<Game>(16, bitgen)) {
+    // Training on a prediction's own outcome must target what the network
+    // output.
+    internal::Evaluation<Game> evaluation;
+    SearchTree<Game, GameNetwork>::EvaluateWithNetwork(game, &network,
+                                                       evaluation);
+    MoveOutcome<Game> move;
+    SetMoveOutcome<Game>(evaluation.outcome, game.CurrentPlayerI(), move);
+    network.SetConstants(network.input_constant_indices(),
+                         game.StateToMatrix());
+    std::vector<nn::DynamicMatrix> outputs;
+    network.Outputs({network.outcome_output_index()}, outputs);
+    for (int i = 0; i < Game::players_n(); ++i) {
+      EXPECT_NEAR(move.outcome(i, 0), outputs[0](i, 0), 1e-5f);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace self_play
+}  // namespace mcts
+}  // namespace azah
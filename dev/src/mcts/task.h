@@ -0,0 +1,74 @@
+#ifndef AZAH_MCTS_TASK_H_
+#define AZAH_MCTS_TASK_H_
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace azah {
+namespace mcts {
+namespace internal {
+
+// A coroutine that runs until it needs something done for it, described by a
+// Request, and waits for whoever runs it to do that before it carries on.
+// This is what lets one thread interleave many searches: each suspends where
+// it would otherwise call the network, and the thread serves all of their
+// requests together.
+//
+// A coroutine returning a Task suspends with
+//
+//   co_await request;
+//
+// which copies the request out for the runner. Tasks start suspended, so
+// nothing runs until the first call to Resume. A task may run another by
+// forwarding its requests:
+//
+//   while (const Request* request = other.Resume()) co_await *request;
+template <typename Request>
+class Task {
+ public:
+  struct promise_type {
+    Request request;
+
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+
+    std::suspend_always await_transform(const Request& request) {
+      this->request = request;
+      return {};
+    }
+  };
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  Task(Task&& other) : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  // Runs the task until it makes its next request, which is returned and
+  // stays valid until the next call. Returns nullptr once the task is done.
+  const Request* Resume() {
+    handle_.resume();
+    return handle_.done() ? nullptr : &(handle_.promise().request);
+  }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) :
+      handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_TASK_H_
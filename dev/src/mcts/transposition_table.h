@@ -0,0 +1,91 @@
+#ifndef AZAH_MCTS_TRANSPOSITION_TABLE_H_
+#define AZAH_MCTS_TRANSPOSITION_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <mutex>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+
+// Maps game state hashes to the index of the search node holding that state.
+//
+// The table is split into shards with their own locks so that search threads
+// rarely wait on one another.
+class TranspositionTable {
+ public:
+  // Returned by FindOrClaim when no node holds the state yet. The caller is
+  // then responsible for creating the node and calling Set.
+  static constexpr std::size_t kAbsent = -1;
+  // Returned by FindOrClaim when another caller is still creating the node.
+  static constexpr std::size_t kPending = -2;
+
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  TranspositionTable() {}
+
+  // Returns the node index for hash, kPending, or kAbsent. Returning kAbsent
+  // claims the hash, so later calls return kPending until Set is called.
+  //
+  // Thread safe.
+  std::size_t FindOrClaim(uint64_t hash) {
+    Shard& shard = shards_[ShardI(hash)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    auto [iter, is_new] = shard.nodes_i.try_emplace(hash, kPending);
+    return is_new ? kAbsent : iter->second;
+  }
+
+  // Gives up a claim on hash made by FindOrClaim, so that the next call
+  // claims it again.
+  //
+  // Thread safe.
+  void Release(uint64_t hash) {
+    Shard& shard = shards_[ShardI(hash)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    auto iter = shard.nodes_i.find(hash);
+    if ((iter != shard.nodes_i.end()) && (iter->second == kPending)) {
+      shard.nodes_i.erase(iter);
+    }
+  }
+
+  // Records the node index for hash.
+  //
+  // Thread safe.
+  void Set(uint64_t hash, std::size_t node_i) {
+    Shard& shard = shards_[ShardI(hash)];
+    std::lock_guard<std::mutex> lock(shard.m);
+    shard.nodes_i[hash] = node_i;
+  }
+
+  // Not thread safe.
+  void clear() {
+    for (auto& shard : shards_) shard.nodes_i.clear();
+  }
+
+ private:
+  static constexpr std::size_t kShardsN = 16;
+
+  struct Shard {
+    std::mutex m;
+    absl::flat_hash_map<uint64_t, std::size_t> nodes_i;  // GUARDED_BY(m)
+  };
+  std::array<Shard, kShardsN> shards_;
+
+  // The low bits pick a bucket within a shard's map, so shards are picked
+  // with the high bits.
+  static inline std::size_t ShardI(uint64_t hash) {
+    return hash >> 60;
+  }
+};
+
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
+
+#endif  // AZAH_MCTS_TRANSPOSITION_TABLE_H_
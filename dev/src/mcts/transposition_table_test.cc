@@ -0,0 +1,129 @@
+#include "transposition_table.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace azah {
+namespace mcts {
+namespace internal {
+namespace {
+
+using Table = TranspositionTable;
+
+TEST(TranspositionTableTest, ClaimsAbsentHashes) {
+  Table table;
+  EXPECT_EQ(table.FindOrClaim(1), Table::kAbsent);
+  EXPECT_EQ(table.FindOrClaim(1), Table::kPending);
+  table.Set(1, 5);
+  EXPECT_EQ(table.FindOrClaim(1), 5u);
+  EXPECT_EQ(table.FindOrClaim(2), Table::kAbsent);
+}
+
+TEST(TranspositionTableTest, ReleaseGivesUpClaims) {
+  Table table;
+  EXPECT_EQ(table.FindOrClaim(1), Table::kAbsent);
+  table.Release(1);
+  EXPECT_EQ(table.FindOrClaim(1), Table::kAbsent);
+
+  // Nodes that were added are kept.
+  table.Set(1, 7);
+  table.Release(1);
+  EXPECT_EQ(table.FindOrClaim(1), 7u);
+  // As are hashes never claimed.
+  table.Release(2);
+  EXPECT_EQ(table.FindOrClaim(2), Table::kAbsent);
+}
+
+TEST(TranspositionTableTest, HashesSharingBitsStayApart) {
+  // The top bits pick the shard, so these share one.
+  const std::vector<uint64_t> same_shard = {
+      0x1000000000000001ull, 0x1000000000000002ull, 0x1fffffffffffffffull};
+  // And these only differ in their shard.
+  const std::vector<uint64_t> same_low_bits = {
+      0x0000000000000001ull, 0x8000000000000001ull, 0xf000000000000001ull};
+  Table table;
+  std::size_t node_i = 0;
+  for (const auto& hashes : {same_shard, same_low_bits}) {
+    for (uint64_t hash : hashes) {
+      ASSERT_EQ(table.FindOrClaim(hash), Table::kAbsent);
+      table.Set(hash, node_i++);
+    }
+  }
+  node_i = 0;
+  for (const auto& hashes : {same_shard, same_low_bits}) {
+    for (uint64_t hash : hashes) EXPECT_EQ(table.FindOrClaim(hash), node_i++);
+  }
+}
+
+TEST(TranspositionTableTest, ClearForgetsNodes) {
+  Table table;
+  table.Set(1, 5);
+  EXPECT_EQ(table.FindOrClaim(2), Table::kAbsent);
+  table.clear();
+  EXPECT_EQ(table.FindOrClaim(1), Table::kAbsent);
+  EXPECT_EQ(table.FindOrClaim(2), Table::kAbsent);
+}
+
+TEST(TranspositionTableTest, OneThreadClaimsEachHash) {
+  constexpr int kThreadsN = 8;
+  constexpr std::size_t kHashesN = 4096;
+  // Spread over the shards.
+  auto hash_of = [](std::size_t i) { return i * 0x9e3779b97f4a7c15ull; };
+  Table table;
+  std::vector<std::atomic<int>> claims_n(kHashesN);
+  std::vector<std::thread> threads;
+  for (int thread_i = 0; thread_i < kThreadsN; ++thread_i) {
+    threads.emplace_back([&, thread_i] {
+          for (std::size_t n = 0; n < kHashesN; ++n) {
+            // Each thread walks the hashes from its own starting point.
+            std::size_t i = (n + thread_i * kHashesN / kThreadsN) % kHashesN;
+            std::size_t node_i = table.FindOrClaim(hash_of(i));
+            if (node_i == Table::kAbsent) {
+              claims_n[i].fetch_add(1);
+              table.Set(hash_of(i), i);
+            } else if (node_i != Table::kPending) {
+              EXPECT_EQ(node_i, i);
+            }
+          }
+        });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (std::size_t i = 0; i < kHashesN; ++i) {
+    EXPECT_EQ(claims_n[i].load(), 1);
+    EXPECT_EQ(table.FindOrClaim(hash_of(i)), i);
+  }
+}
+
+TEST(TranspositionTableTest, ReleasedClaimsAreClaimedAgain) {
+  constexpr int kThreadsN = 8;
+  constexpr int kRoundsN = 1000;
+  Table table;
+  // Every thread claims the same hash and gives it back, so at most one holds
+  // it at a time.
+  std::atomic<int> holders_n = 0;
+  std::vector<std::thread> threads;
+  for (int thread_i = 0; thread_i < kThreadsN; ++thread_i) {
+    threads.emplace_back([&] {
+          for (int round_i = 0; round_i < kRoundsN; ++round_i) {
+            if (table.FindOrClaim(1) != Table::kAbsent) continue;
+            EXPECT_EQ(holders_n.fetch_add(1), 0);
+            holders_n.fetch_sub(1);
+            table.Release(1);
+          }
+        });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(table.FindOrClaim(1), Table::kAbsent);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mcts
+}  // namespace azah
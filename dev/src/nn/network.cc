@@ -1,5 +1,6 @@
 #include "network.h"
 
+#include <atomic>
 #include <vector>
 
 #include "data_types.h"
@@ -49,6 +50,7 @@ void Network::Gradients(const std::vector<uint32_t>& targets_i,
 
 void Network::GetVariables(const std::vector<uint32_t>& variables_i,
                            std::vector<DynamicMatrixRef>& variables) {
+  version_ = NewVersion();
   variables.clear();
   if (variables_i.empty()) {
     for (auto var : variables_) {
@@ -88,7 +90,19 @@ void Network::SetConstants(const std::vector<uint32_t>& constants_i,
   }
 }
 
-Network::Network() : cycle_(0) {}
+void Network::CopyVariables(const Network& src) {
+  std::vector<ConstDynamicMatrixRef> variables;
+  src.GetVariables({}, variables);
+  SetVariables({}, variables);
+  version_ = src.version_;
+}
+
+Network::Network() : cycle_(0), version_(NewVersion()) {}
+
+uint64_t Network::NewVersion() {
+  static std::atomic<uint64_t> next_version(0);
+  return next_version.fetch_add(1, std::memory_order_relaxed);
+}
 
 void Network::AddOutput(NodeBase* output) {
   outputs_.push_back(output);
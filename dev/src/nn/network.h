@@ -38,6 +38,7 @@ class Network {
             || std::is_same<SourceDynamicMatrix, DynamicMatrixRef>()
             || std::is_same<SourceDynamicMatrix, ConstDynamicMatrixRef>(), 
         "Variable type must be a dynamic matrix.");
+    version_ = NewVersion();
     if (variables_i.empty()) {
       if (variables.size() != variables_.size()) {
         LOG(FATAL) << "Number of provided variables does not match the number "
@@ -54,7 +55,8 @@ class Network {
     }
   }
 
-  // Leave variables_i empty to retrieve all variables.
+  // Leave variables_i empty to retrieve all variables. Since the variables can
+  // then be written through, this counts as a change to them.
   void GetVariables(const std::vector<uint32_t>& variables_i, 
                     std::vector<DynamicMatrixRef>& variables);
 
@@ -65,6 +67,19 @@ class Network {
   void SetConstants(const std::vector<uint32_t>& constants_i, 
                     const std::vector<DynamicMatrix>& constants);
 
+  // Sets every variable to those of src, which must be the same kind of
+  // network. The two then share a version.
+  void CopyVariables(const Network& src);
+
+  // Identifies the current values of the variables: no two networks ever share
+  // a version unless one's variables were copied from the other's with
+  // CopyVariables, and it changes whenever the variables may have. Outputs
+  // computed with one version can be cached under it.
+  uint64_t version() const { return version_; }
+
+  // The number of calls to Outputs and Gradients so far.
+  uint32_t cycle() const { return cycle_; }
+
  protected:
   Network();
 
@@ -79,7 +94,11 @@ class Network {
   }
 
  private:
+  // Returns a version that's never been returned before. Thread safe.
+  static uint64_t NewVersion();
+
   uint32_t cycle_;
+  uint64_t version_;
   
   std::vector<NodeBase*> outputs_;
   std::vector<NodeBase*> targets_;
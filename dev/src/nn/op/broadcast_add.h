@@ -11,19 +11,27 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int Rows, int Cols>
-class BroadcastAdd : public BinaryOp<Rows, 1, Rows, Cols, Rows, Cols> {
+// Adds column b of A to every column of block b of B, which holds BatchN
+// Rows x Cols blocks side by side.
+template <int Rows, int Cols, int BatchN = 1>
+class BroadcastAdd : public BinaryOp<Rows, BatchN, Rows, Cols * BatchN, 
+                                     Rows, Cols * BatchN> {
  public:
   BroadcastAdd(const BroadcastAdd&) = delete;
   BroadcastAdd& operator=(const BroadcastAdd&) = delete;
 
-  BroadcastAdd(Node<Rows, 1>& input_a, Node<Rows, Cols>& input_b)
-      : BinaryOp<Rows, 1, Rows, Cols, Rows, Cols>(input_a, input_b) {}
+  BroadcastAdd(Node<Rows, BatchN>& input_a, Node<Rows, Cols * BatchN>& input_b)
+      : BinaryOp<Rows, BatchN, Rows, Cols * BatchN, Rows, Cols * BatchN>(
+            input_a, input_b) {}
 
   void Backprop(uint32_t cycle, 
-                const MatrixRef<Rows, Cols>& output_dx) override {
+                const MatrixRef<Rows, Cols * BatchN>& output_dx) override {
     if (!this->input_a_.constant) {
-      this->input_a_.Backprop(cycle, output_dx.rowwise().sum());
+      Matrix<Rows, BatchN> a_dx;
+      for (int b = 0; b < BatchN; ++b) {
+        a_dx.col(b) = output_dx.middleCols(b * Cols, Cols).rowwise().sum();
+      }
+      this->input_a_.Backprop(cycle, a_dx);
     }
     if (!this->input_b_.constant) {
       this->input_b_.Backprop(cycle, output_dx);
@@ -34,7 +42,10 @@ class BroadcastAdd : public BinaryOp<Rows, 1, Rows, Cols, Rows, Cols> {
   void ComputeOutput(uint32_t cycle) override {
     const auto& a = this->input_a_.Output(cycle);
     const auto& b = this->input_b_.Output(cycle);
-    this->cached_output_ = b.colwise() + a;
+    for (int i = 0; i < BatchN; ++i) {
+      this->cached_output_.middleCols(i * Cols, Cols) = 
+          b.middleCols(i * Cols, Cols).colwise() + a.col(i);
+    }
   }
 };
 
@@ -12,9 +12,13 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int InputRowsA, int InputColsA, int OutputCols>
-class BroadcastMatmul : public BinaryOp<InputRowsA, InputColsA, InputColsA, 1,
-                                        InputRowsA / OutputCols, OutputCols> {
+// Multiplies A by each column of B, and splits each product into OutputCols
+// columns of InputRowsA / OutputCols rows. With BatchN > 1, B's columns are
+// those of a batch, and their results are laid side by side.
+template <int InputRowsA, int InputColsA, int OutputCols, int BatchN = 1>
+class BroadcastMatmul 
+    : public BinaryOp<InputRowsA, InputColsA, InputColsA, BatchN,
+                      InputRowsA / OutputCols, OutputCols * BatchN> {
   static_assert(InputRowsA % OutputCols == 0,
                 "The output columns must divide the rows of A.");
  public:
@@ -22,44 +26,43 @@ class BroadcastMatmul : public BinaryOp<InputRowsA, InputColsA, InputColsA, 1,
   BroadcastMatmul& operator=(const BroadcastMatmul&) = delete;
 
   BroadcastMatmul(Node<InputRowsA, InputColsA>& input_a,
-                  Node<InputColsA, 1>& input_b) :
-      BinaryOp<InputRowsA, InputColsA, InputColsA, 1, InputRowsA / OutputCols,
-               OutputCols>(input_a, input_b) {}
+                  Node<InputColsA, BatchN>& input_b) :
+      BinaryOp<InputRowsA, InputColsA, InputColsA, BatchN, 
+               InputRowsA / OutputCols, OutputCols * BatchN>(input_a, 
+                                                             input_b) {}
 
   void Backprop(
       uint32_t cycle,
       const MatrixRef<InputRowsA / OutputCols, 
-                      OutputCols>& output_dx) override {
-    if (!this->input_a_.constant) {
-      Matrix<InputRowsA, InputColsA> j;
-      auto b_trans = this->input_b_.Output(cycle).transpose();
+                      OutputCols * BatchN>& output_dx) override {
+    // Each column of the output is a slice of one column of A * B.
+    Matrix<InputRowsA, BatchN> product_dx;
+    for (int b = 0; b < BatchN; ++b) {
       for (int c = 0; c < OutputCols; ++c) {
-        j.middleRows(c * (InputRowsA / OutputCols), InputRowsA / OutputCols) = 
-            output_dx.col(c) * b_trans;
+        product_dx.col(b).segment(c * kSliceRows, kSliceRows) = 
+            output_dx.col(b * OutputCols + c);
       }
-      this->input_a_.Backprop(cycle, j);
+    }
+    if (!this->input_a_.constant) {
+      this->input_a_.Backprop(
+          cycle, product_dx * this->input_b_.Output(cycle).transpose());
     }
     if (!this->input_b_.constant) {
-      Matrix<InputColsA, 1> j = init::Zeros<InputColsA, 1>();
-      auto a_trans = this->input_a_.Output(cycle).transpose();
-      for (int c = 0; c < OutputCols; ++c) {
-        j += a_trans.middleCols(
-            c * (InputRowsA / OutputCols), 
-            InputRowsA / OutputCols) * output_dx.col(c);
-      }
-      this->input_b_.Backprop(cycle, j);
+      this->input_b_.Backprop(
+          cycle, this->input_a_.Output(cycle).transpose() * product_dx);
     }
   }
 
  private:
+  static constexpr int kSliceRows = InputRowsA / OutputCols;
+
   void ComputeOutput(uint32_t cycle) override {
     const auto& a = this->input_a_.Output(cycle);
     const auto& b = this->input_b_.Output(cycle);
-    for (int c = 0; c < OutputCols; ++c) {
-      this->cached_output_.col(c) = 
-          a.middleRows(c * (InputRowsA / OutputCols), 
-                       InputRowsA / OutputCols) * b;
-    }
+    // Column-major, the output holds exactly the columns of A * B one after
+    // another, so the whole batch is a single product.
+    Eigen::Map<Matrix<InputRowsA, BatchN>>(
+        this->cached_output_.data()).noalias() = a * b;
   }
 };
 
@@ -11,33 +11,58 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int InputRows, int InputColsA, int InputColsB>
-class ConcatCols : public BinaryOp<InputRows, InputColsA, InputRows, InputColsB, 
-                                   InputRows, InputColsA + InputColsB> {
+// Concatenates the columns of A and B, or with BatchN > 1, those of each of
+// the BatchN blocks laid side by side in them.
+template <int InputRows, int InputColsA, int InputColsB, int BatchN = 1>
+class ConcatCols 
+    : public BinaryOp<InputRows, InputColsA * BatchN, 
+                      InputRows, InputColsB * BatchN, 
+                      InputRows, (InputColsA + InputColsB) * BatchN> {
  public:
   ConcatCols(const ConcatCols&) = delete;
   ConcatCols& operator=(const ConcatCols&) = delete;
 
-  ConcatCols(Node<InputRows, InputColsA>& input_a,
-             Node<InputRows, InputColsB>& input_b)
-      : BinaryOp<InputRows, InputColsA, InputRows, InputColsB, 
-                 InputRows, InputColsA + InputColsB>(input_a, input_b) {}
+  ConcatCols(Node<InputRows, InputColsA * BatchN>& input_a,
+             Node<InputRows, InputColsB * BatchN>& input_b)
+      : BinaryOp<InputRows, InputColsA * BatchN, InputRows, 
+                 InputColsB * BatchN, InputRows, 
+                 (InputColsA + InputColsB) * BatchN>(input_a, input_b) {}
 
   void Backprop(
       uint32_t cycle,
-      const MatrixRef<InputRows, InputColsA + InputColsB>& output_dx) override {
+      const MatrixRef<InputRows, 
+                      (InputColsA + InputColsB) * BatchN>& output_dx) override {
     if (!this->input_a_.constant) {
-      this->input_a_.Backprop(cycle, output_dx.leftCols(InputColsA));
+      Matrix<InputRows, InputColsA * BatchN> a_dx;
+      for (int b = 0; b < BatchN; ++b) {
+        a_dx.middleCols(b * InputColsA, InputColsA) = 
+            output_dx.middleCols(b * kColsN, InputColsA);
+      }
+      this->input_a_.Backprop(cycle, a_dx);
     }
     if (!this->input_b_.constant) {
-      this->input_b_.Backprop(cycle, output_dx.rightCols(InputColsB));
+      Matrix<InputRows, InputColsB * BatchN> b_dx;
+      for (int b = 0; b < BatchN; ++b) {
+        b_dx.middleCols(b * InputColsB, InputColsB) = 
+            output_dx.middleCols(b * kColsN + InputColsA, InputColsB);
+      }
+      this->input_b_.Backprop(cycle, b_dx);
     }
   }
 
  private:
+  // The columns of each block of the output.
+  static constexpr int kColsN = InputColsA + InputColsB;
+
   void ComputeOutput(uint32_t cycle) override {
-    this->cached_output_.leftCols(InputColsA) = this->input_a_.Output(cycle);
-    this->cached_output_.rightCols(InputColsB) = this->input_b_.Output(cycle);
+    const auto& a = this->input_a_.Output(cycle);
+    const auto& b = this->input_b_.Output(cycle);
+    for (int i = 0; i < BatchN; ++i) {
+      this->cached_output_.middleCols(i * kColsN, InputColsA) = 
+          a.middleCols(i * InputColsA, InputColsA);
+      this->cached_output_.middleCols(i * kColsN + InputColsA, InputColsB) = 
+          b.middleCols(i * InputColsB, InputColsB);
+    }
   }
 };
 
@@ -56,10 +56,12 @@ class Matmul : public BinaryOp<InputRowsA, InputColsA, InputRowsB, InputColsB,
   void ComputeOutput(uint32_t cycle) override {
     const auto& a = this->input_a_.Output(cycle);
     const auto& b = this->input_b_.Output(cycle);
+    // The inputs are other nodes' outputs, so there's no aliasing, and
+    // writing the product in place spares a temporary the size of the output.
     if constexpr (TransposeRHS) {
-      this->cached_output_ = a * b.transpose();
+      this->cached_output_.noalias() = a * b.transpose();
     } else {
-      this->cached_output_ = a * b;
+      this->cached_output_.noalias() = a * b;
     }
   }
 };
@@ -24,18 +24,23 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int Rows, int Cols, int TokenHiddenSize, int FeatureHiddenSize>
-class Mixer : public Op<Rows, Cols, 8> {
+// An MLP-Mixer layer over Rows x Cols inputs, or with BatchN > 1, over each of
+// BatchN such inputs laid side by side. Tokens are only ever mixed within an
+// input.
+template <int Rows, int Cols, int TokenHiddenSize, int FeatureHiddenSize,
+          int BatchN = 1>
+class Mixer : public Op<Rows, Cols * BatchN, 8> {
  public:
   Mixer(const Mixer&) = delete;
   Mixer& operator=(const Mixer&) = delete;
 
-  Mixer(Node<Rows, Cols>& input)
-      : Op<Rows, Cols, 8>(input.constant),
+  Mixer(Node<Rows, Cols * BatchN>& input)
+      : Op<Rows, Cols * BatchN, 8>(input.constant),
         fork_t_(input, 2),
         norm_t_(fork_t_),
+        transpose_t_(norm_t_),
         dense_t_1_k_(init::GlorotUniform<TokenHiddenSize, Cols>()),
-        dense_t_1_(dense_t_1_k_, norm_t_),
+        dense_t_1_(dense_t_1_k_, transpose_t_),
         swish_t_(dense_t_1_),
         dense_t_2_k_(init::GlorotUniform<Cols, TokenHiddenSize>()),
         dense_t_2_(dense_t_2_k_, swish_t_),
@@ -55,11 +60,11 @@ class Mixer : public Op<Rows, Cols, 8> {
             &dense_f_1_k_, &dense_f_2_k_} {}
 
   void Backprop(uint32_t cycle, 
-                const MatrixRef<Rows, Cols>& output_dx) override {
+                const MatrixRef<Rows, Cols * BatchN>& output_dx) override {
     this->res_f_.Backprop(cycle, output_dx);
   }
 
-  const Matrix<Rows, Cols>& Output(uint32_t cycle) override {
+  const Matrix<Rows, Cols * BatchN>& Output(uint32_t cycle) override {
     return this->res_f_.Output(cycle);
   }
 
@@ -68,24 +73,29 @@ class Mixer : public Op<Rows, Cols, 8> {
   }
 
  private:
-  Fork<Rows, Cols> fork_t_;
-  LayerNorm<Rows, Cols> norm_t_;
+  static constexpr int kWidth = Cols * BatchN;
+
+  // Token mixing works on the transpose of each input, which puts the inputs'
+  // tokens in the rows of one wide matrix a single product can mix.
+  Fork<Rows, kWidth> fork_t_;
+  LayerNorm<Rows, kWidth> norm_t_;
+  Transpose<Rows, Cols, BatchN> transpose_t_;
   Variable<TokenHiddenSize, Cols> dense_t_1_k_;
-  Matmul<TokenHiddenSize, Cols, Rows, Cols, true> dense_t_1_;
-  Swish<TokenHiddenSize, Rows> swish_t_;
+  Matmul<TokenHiddenSize, Cols, Cols, Rows * BatchN> dense_t_1_;
+  Swish<TokenHiddenSize, Rows * BatchN> swish_t_;
   Variable<Cols, TokenHiddenSize> dense_t_2_k_;
-  Matmul<Cols, TokenHiddenSize, TokenHiddenSize, Rows> dense_t_2_;
-  Transpose<Cols, Rows> transpose_;
-  Add<Rows, Cols> res_t_;
+  Matmul<Cols, TokenHiddenSize, TokenHiddenSize, Rows * BatchN> dense_t_2_;
+  Transpose<Cols, Rows, BatchN> transpose_;
+  Add<Rows, kWidth> res_t_;
 
-  Fork<Rows, Cols> fork_f_;
-  LayerNorm<Rows, Cols> norm_f_;
+  Fork<Rows, kWidth> fork_f_;
+  LayerNorm<Rows, kWidth> norm_f_;
   Variable<FeatureHiddenSize, Rows> dense_f_1_k_;
-  Matmul<FeatureHiddenSize, Rows, Rows, Cols> dense_f_1_;
-  Swish<FeatureHiddenSize, Cols> swish_f_;
+  Matmul<FeatureHiddenSize, Rows, Rows, kWidth> dense_f_1_;
+  Swish<FeatureHiddenSize, kWidth> swish_f_;
   Variable<Rows, FeatureHiddenSize> dense_f_2_k_;
-  Matmul<Rows, FeatureHiddenSize, FeatureHiddenSize, Cols> dense_f_2_;
-  Add<Rows, Cols> res_f_;
+  Matmul<Rows, FeatureHiddenSize, FeatureHiddenSize, kWidth> dense_f_2_;
+  Add<Rows, kWidth> res_f_;
 
   const std::array<VariableBase*, 8> variables_;
 
@@ -11,25 +11,34 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int Rows, int Cols>
-class RowMean : public UnaryOp<Rows, Cols, Rows, 1> {
+// The mean of each row of each of BatchN Rows x Cols blocks laid side by side,
+// giving a column per block.
+template <int Rows, int Cols, int BatchN = 1>
+class RowMean : public UnaryOp<Rows, Cols * BatchN, Rows, BatchN> {
  public:
   RowMean(const RowMean&) = delete;
   RowMean& operator=(const RowMean&) = delete;
 
-  RowMean(Node<Rows, Cols>& input) : UnaryOp<Rows, Cols, Rows, 1>(input) {}
+  RowMean(Node<Rows, Cols * BatchN>& input) 
+      : UnaryOp<Rows, Cols * BatchN, Rows, BatchN>(input) {}
 
  private:
   void ComputeOutput(uint32_t cycle) override {
     const auto& x = this->input_.Output(cycle);
-    this->cached_output_ = x.rowwise().mean();
+    for (int b = 0; b < BatchN; ++b) {
+      this->cached_output_.col(b) = 
+          x.middleCols(b * Cols, Cols).rowwise().mean();
+    }
   }
 
   void UnaryBackprop(uint32_t cycle, 
-                     const MatrixRef<Rows, 1>& output_dx) override {
-    this->input_.Backprop(
-        cycle,
-        (output_dx / static_cast<float>(Cols)).rowwise().replicate<Cols>());
+                     const MatrixRef<Rows, BatchN>& output_dx) override {
+    Matrix<Rows, Cols * BatchN> input_dx;
+    for (int b = 0; b < BatchN; ++b) {
+      input_dx.middleCols(b * Cols, Cols) = 
+          (output_dx.col(b) / static_cast<float>(Cols)).replicate(1, Cols);
+    }
+    this->input_.Backprop(cycle, input_dx);
   }
 };
 
@@ -36,9 +36,14 @@ class Softmax : public UnaryOp<Rows, Cols, Rows, Cols> {
                   "SoftmaxCrossEnt instead?";
   }
 
-  static inline auto SoftmaxExpr(const MatrixRef<Rows, Cols>& x) {
-    auto x_exp = (x.array() - x.maxCoeff()).exp();
-    return x_exp / x_exp.sum();
+  // Each column is normalized on its own, so a batch of inputs laid side by
+  // side gets the softmax of each.
+  static inline Eigen::Array<float, Rows, Cols> SoftmaxExpr(
+      const MatrixRef<Rows, Cols>& x) {
+    Eigen::Array<float, Rows, Cols> x_exp = 
+        (x.array().rowwise() - x.array().colwise().maxCoeff()).exp();
+    x_exp.rowwise() /= x_exp.colwise().sum().eval();
+    return x_exp;
   }
 };
 
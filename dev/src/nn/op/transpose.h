@@ -11,22 +11,36 @@ namespace azah {
 namespace nn {
 namespace op {
 
-template <int Rows, int Cols>
-class Transpose : public UnaryOp<Rows, Cols, Cols, Rows> {
+// Transposes each of BatchN Rows x Cols blocks laid side by side, in place in
+// the batch.
+template <int Rows, int Cols, int BatchN = 1>
+class Transpose 
+    : public UnaryOp<Rows, Cols * BatchN, Cols, Rows * BatchN> {
  public:
   Transpose(const Transpose&) = delete;
   Transpose& operator=(const Transpose&) = delete;
 
-  Transpose(Node<Rows, Cols>& input) : UnaryOp<Rows, Cols, Cols, Rows>(input) {}
+  Transpose(Node<Rows, Cols * BatchN>& input) 
+      : UnaryOp<Rows, Cols * BatchN, Cols, Rows * BatchN>(input) {}
 
  private:
   void ComputeOutput(uint32_t cycle) override {
-    this->cached_output_ = this->input_.Output(cycle).transpose();
+    const auto& x = this->input_.Output(cycle);
+    for (int b = 0; b < BatchN; ++b) {
+      this->cached_output_.middleCols(b * Rows, Rows) = 
+          x.middleCols(b * Cols, Cols).transpose();
+    }
   }
 
-  void UnaryBackprop(uint32_t cycle,
-                     const MatrixRef<Cols, Rows>& output_dx) override {
-    this->input_.Backprop(cycle, output_dx.transpose());
+  void UnaryBackprop(
+      uint32_t cycle,
+      const MatrixRef<Cols, Rows * BatchN>& output_dx) override {
+    Matrix<Rows, Cols * BatchN> input_dx;
+    for (int b = 0; b < BatchN; ++b) {
+      input_dx.middleCols(b * Cols, Cols) = 
+          output_dx.middleCols(b * Rows, Rows).transpose();
+    }
+    this->input_.Backprop(cycle, input_dx);
   }
 };
 
@@ -32,22 +32,31 @@ class DispatchQueue {
     if (queue_length <= 0) {
       LOG(FATAL) << "Queue length must be greater than 0.";
     }
+    for (uint32_t i = 0; i < queue_length; ++i) {
+      buffer_[i].turn.store(i, std::memory_order_relaxed);
+    }
     for (int i = 0; i < threads; ++i) {
       auto dispatch_fn = [this, i] {
             for (;;) {
               buffer_elem_remain_.P();
               if (exit_) return;
-              WorkElement& work_element = buffer_[
-                  slot_working_.fetch_add(1, std::memory_order_relaxed) 
-                      % buffer_.size()];
-              while (!work_element.ready.load(std::memory_order_relaxed)) {}
-
-              (*(work_element.work))(this->thread_state_[i]);
-              work_element.work.reset();
+              uint64_t slot =
+                  slot_working_.fetch_add(1, std::memory_order_relaxed);
+              WorkElement& work_element = buffer_[slot % buffer_.size()];
+              while (work_element.turn.load(std::memory_order_acquire)
+                     != slot + 1) {}
+
+              // Free the slot before running the work, so slots are handed
+              // on in order however long each work item takes.
+              std::unique_ptr<CallableWorkItem> work =
+                  std::move(work_element.work);
+              work_element.turn.store(slot + buffer_.size(),
+                                      std::memory_order_release);
+              buffer_avail_.V();
 
+              (*work)(this->thread_state_[i]);
+              work.reset();
               drain_.Inc();
-              work_element.ready.exchange(false, std::memory_order_release);
-              buffer_avail_.V();
             }
           };
       workers_.emplace_back(dispatch_fn);
@@ -66,10 +75,13 @@ class DispatchQueue {
   void AddWork(std::unique_ptr<CallableWorkItem> work) {
     drain_.Dec();
     buffer_avail_.P();
-    WorkElement& work_element =
-        buffer_[slot_.fetch_add(1, std::memory_order_relaxed) % buffer_.size()];
+    uint64_t slot = slot_.fetch_add(1, std::memory_order_relaxed);
+    WorkElement& work_element = buffer_[slot % buffer_.size()];
+    // A free slot may still hold the work of a lap ago until its worker takes
+    // it.
+    while (work_element.turn.load(std::memory_order_acquire) != slot) {}
     work_element.work = std::move(work);
-    work_element.ready.exchange(true, std::memory_order_acquire);
+    work_element.turn.store(slot + 1, std::memory_order_release);
     buffer_elem_remain_.V();
   }
 
@@ -94,13 +106,15 @@ class DispatchQueue {
 
   Semaphore drain_;
 
-  std::atomic_uint32_t slot_;
-  std::atomic_uint32_t slot_working_;
+  std::atomic_uint64_t slot_;
+  std::atomic_uint64_t slot_working_;
 
+  // The slot of the n-th work item is n % buffer_.size(). Its turn is n while
+  // the slot waits for that item, and n + 1 once the item is in it.
   struct WorkElement {
-    WorkElement() : ready(false) {}
+    WorkElement() : turn(0) {}
     std::unique_ptr<CallableWorkItem> work;
-    std::atomic<bool> ready;
+    std::atomic_uint64_t turn;
   };
   std::vector<WorkElement> buffer_;
 
@@ -35,7 +35,8 @@ void Semaphore::V() {
 
 void Semaphore::Wait() {
   std::shared_lock<std::shared_mutex> s_lock(m_);
-  if (r_.load(std::memory_order_acquire) <= 0) cv_.wait(s_lock);
+  // A wakeup may be spurious, or left over from an Inc that was already seen.
+  cv_.wait(s_lock, [this] { return r_.load(std::memory_order_acquire) > 0; });
 }
 
 void Semaphore::Dec() {